@@ -1,7 +1,8 @@
 #include "ArtManager.h"
+#include "ImageCache.h"
+#include "ThumbnailService.h"
 
 #include <QDirIterator>
-#include <QPixmapCache>
 
 QHash<QString, QIcon> ArtManager::icons;
 QBrush ArtManager::transparenyBrush;
@@ -15,8 +16,6 @@ void ArtManager::Init() {
   }
 
   transparenyBrush = QBrush(Qt::black, QPixmap(":/transparent.png"));
-
-  QPixmapCache::setCacheLimit(500000);  // 500mb cache limit
 }
 
 ArtManager::ArtManager() {}
@@ -27,15 +26,13 @@ const QIcon& ArtManager::GetIcon(const QString& name) {
   return icons[name];
 }
 
+QIcon ArtManager::GetThumbnail(const QString& file) { return ThumbnailService::Icon(file); }
+
 const QBrush& ArtManager::GetTransparenyBrush() { return transparenyBrush; }
 
-const QPixmap& ArtManager::GetCachedPixmap(const QString& name) {
-  static QPixmap pm;
-  if (!QPixmapCache::find(name, &pm)) {
-    pm.load(name);
-    QPixmapCache::insert(name, pm);
-  }
-  return std::move(pm);
-}
+QPixmap ArtManager::GetCachedPixmap(const QString& name) { return ImageCache::Pixmap(name); }
 
-void ArtManager::clearCache() { QPixmapCache::clear(); }
+void ArtManager::clearCache() {
+  ImageCache::Clear();
+  ThumbnailService::Clear();
+}
@@ -9,8 +9,11 @@ class ArtManager {
  public:
   static void Init();
   static const QIcon& GetIcon(const QString& name);
+  // Preview of an image file; a placeholder until it has been decoded in the background (see ThumbnailService).
+  static QIcon GetThumbnail(const QString& file);
   static const QBrush& GetTransparenyBrush();
-  static const QPixmap& GetCachedPixmap(const QString& name);
+  // Decoded once and shared; see ImageCache.
+  static QPixmap GetCachedPixmap(const QString& name);
   static void clearCache();
 
  private:
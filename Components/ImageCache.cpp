@@ -0,0 +1,183 @@
+#include "ImageCache.h"
+
+#include <QCryptographicHash>
+#include <QImageReader>
+
+QHash<QByteArray, ImageCache::Content> ImageCache::_contents;
+std::list<QString> ImageCache::_imageOrder;
+QHash<QString, std::pair<QByteArray, std::list<QString>::iterator>> ImageCache::_images;
+QHash<QString, QByteArray> ImageCache::_digests;
+std::list<QByteArray> ImageCache::_pixmapOrder;
+QHash<QByteArray, std::pair<QPixmap, std::list<QByteArray>::iterator>> ImageCache::_pixmaps;
+qint64 ImageCache::_imageBudget = 256 * 1024 * 1024;
+qint64 ImageCache::_pixmapBudget = 256 * 1024 * 1024;
+ImageCache::Stats ImageCache::_stats;
+
+namespace {
+
+qint64 ImageBytes(const QImage &image) { return qint64(image.bytesPerLine()) * image.height(); }
+qint64 PixmapBytes(const QPixmap &pixmap) { return qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8; }
+
+}  // namespace
+
+QByteArray ImageCache::Digest(const QImage &image) {
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  const int header[] = {image.width(), image.height(), image.format()};
+  hash.addData(reinterpret_cast<const char *>(header), sizeof(header));
+  // Row by row, so that whatever sits in the padding at the end of each line doesn't count.
+  const int lineBytes = (image.width() * image.depth() + 7) / 8;
+  for (int y = 0; y < image.height(); ++y) {
+    hash.addData(reinterpret_cast<const char *>(image.constScanLine(y)), lineBytes);
+  }
+  return hash.result();
+}
+
+QImage ImageCache::Image(const QString &path) {
+  auto it = _images.find(path);
+  if (it != _images.end()) {
+    ++_stats.imageHits;
+    _imageOrder.splice(_imageOrder.begin(), _imageOrder, it->second);
+    return _contents[it->first].image;
+  }
+
+  ++_stats.imageMisses;
+  const QImage image = QImageReader(path).read();
+  if (image.isNull()) return image;
+  return Adopt(path, image, Digest(image));
+}
+
+QImage ImageCache::Cached(const QString &path) {
+  auto it = _images.find(path);
+  if (it == _images.end()) {
+    ++_stats.imageMisses;
+    return QImage();
+  }
+  ++_stats.imageHits;
+  _imageOrder.splice(_imageOrder.begin(), _imageOrder, it->second);
+  return _contents[it->first].image;
+}
+
+QImage ImageCache::Insert(const QString &path, const QImage &image, const QByteArray &digest) {
+  if (image.isNull()) return image;
+  auto it = _images.find(path);
+  if (it != _images.end()) {
+    _imageOrder.erase(it->second);
+    Release(it->first);
+    _images.erase(it);
+  }
+  return Adopt(path, image, digest);
+}
+
+QImage ImageCache::Derived(const QString &key) { return Cached(key); }
+
+void ImageCache::InsertDerived(const QString &key, const QImage &image) { Insert(key, image, Digest(image)); }
+
+QImage ImageCache::Adopt(const QString &path, QImage image, const QByteArray &digest) {
+  Content &content = _contents[digest];
+  if (content.users++ > 0) {
+    ++_stats.sharedLoads;
+    // Drop our copy in favor of the one already cached.
+    image = content.image;
+  } else {
+    content.image = image;
+    _stats.imageBytes += ImageBytes(image);
+  }
+  _imageOrder.push_front(path);
+  _images.insert(path, {digest, _imageOrder.begin()});
+  _digests.insert(path, digest);
+  EvictImages();
+  return image;
+}
+
+QPixmap ImageCache::Pixmap(const QString &path) {
+  auto digest = _digests.constFind(path);
+  if (digest != _digests.constEnd()) {
+    auto it = _pixmaps.find(*digest);
+    if (it != _pixmaps.end()) {
+      ++_stats.pixmapHits;
+      _pixmapOrder.splice(_pixmapOrder.begin(), _pixmapOrder, it->second);
+      return it->first;
+    }
+  }
+
+  ++_stats.pixmapMisses;
+  const QImage image = Image(path);
+  if (image.isNull()) return QPixmap();
+  const QByteArray &key = _digests[path];
+  QPixmap pixmap = QPixmap::fromImage(image);
+  _pixmapOrder.push_front(key);
+  _pixmaps.insert(key, {pixmap, _pixmapOrder.begin()});
+  _stats.pixmapBytes += PixmapBytes(pixmap);
+  EvictPixmaps();
+  return pixmap;
+}
+
+void ImageCache::Release(const QByteArray &digest) {
+  auto it = _contents.find(digest);
+  if (it == _contents.end() || --it->users > 0) return;
+  _stats.imageBytes -= ImageBytes(it->image);
+  _contents.erase(it);
+}
+
+void ImageCache::EvictImages() {
+  // The newest image always stays, however large.
+  while (_stats.imageBytes > _imageBudget && _imageOrder.size() > 1) {
+    const QString path = _imageOrder.back();
+    _imageOrder.pop_back();
+    Release(_images.take(path).first);
+    ++_stats.imageEvictions;
+  }
+}
+
+void ImageCache::EvictPixmaps() {
+  while (_stats.pixmapBytes > _pixmapBudget && _pixmapOrder.size() > 1) {
+    const QByteArray digest = _pixmapOrder.back();
+    _pixmapOrder.pop_back();
+    _stats.pixmapBytes -= PixmapBytes(_pixmaps.take(digest).first);
+    ++_stats.pixmapEvictions;
+  }
+}
+
+void ImageCache::Clear() {
+  _contents.clear();
+  _imageOrder.clear();
+  _images.clear();
+  _digests.clear();
+  _pixmapOrder.clear();
+  _pixmaps.clear();
+  _stats.imageBytes = 0;
+  _stats.pixmapBytes = 0;
+}
+
+void ImageCache::SetBudgets(qint64 imageBytes, qint64 pixmapBytes) {
+  _imageBudget = imageBytes;
+  _pixmapBudget = pixmapBytes;
+  EvictImages();
+  EvictPixmaps();
+}
+
+ImageCache::Stats ImageCache::GetStats() {
+  Stats stats = _stats;
+  stats.images = _contents.size();
+  stats.pixmaps = _pixmaps.size();
+  return stats;
+}
+
+QString ImageCache::StatsSummary() {
+  const Stats stats = GetStats();
+  const auto megabytes = [](qint64 bytes) { return QString::number(bytes / (1024.0 * 1024.0), 'f', 1); };
+  return QString(
+             "Image cache: %1 images (%2 MB of %3 MB), %4 hits, %5 misses, %6 evictions, %7 loads shared with an "
+             "identical image\nPixmap cache: %8 pixmaps (%9 MB of %10 MB), %11 hits, %12 misses, %13 evictions")
+      .arg(stats.images)
+      .arg(megabytes(stats.imageBytes), megabytes(_imageBudget))
+      .arg(stats.imageHits)
+      .arg(stats.imageMisses)
+      .arg(stats.imageEvictions)
+      .arg(stats.sharedLoads)
+      .arg(stats.pixmaps)
+      .arg(megabytes(stats.pixmapBytes), megabytes(_pixmapBudget))
+      .arg(stats.pixmapHits)
+      .arg(stats.pixmapMisses)
+      .arg(stats.pixmapEvictions);
+}
@@ -0,0 +1,81 @@
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QPixmap>
+#include <QString>
+
+#include <list>
+#include <utility>
+
+// Images read from disk, decoded once and kept in two byte-budgeted LRU tiers: decoded QImages, and the QPixmaps
+// (video memory on most platforms) made from them. Images are also keyed by a hash of their pixels, so identical
+// files (e.g. the same subimage in several sprites) share one copy in each tier.
+// Only meant for use from the GUI thread.
+class ImageCache {
+ public:
+  struct Stats {
+    qint64 imageHits = 0;
+    qint64 imageMisses = 0;
+    qint64 imageEvictions = 0;
+    qint64 pixmapHits = 0;
+    qint64 pixmapMisses = 0;
+    qint64 pixmapEvictions = 0;
+    // Loads which turned out to be identical to an image already in the cache.
+    qint64 sharedLoads = 0;
+    qint64 imageBytes = 0;
+    qint64 pixmapBytes = 0;
+    int images = 0;
+    int pixmaps = 0;
+  };
+
+  static QImage Image(const QString &path);
+  static QPixmap Pixmap(const QString &path);
+  // The image cached under the path, or a null image if there is none; unlike Image(), never reads the file.
+  static QImage Cached(const QString &path);
+  // Files an image decoded off the GUI thread under the path, as if Image() had read it. `digest` must be
+  // Digest(image), which the worker that decoded it can compute as well.
+  static QImage Insert(const QString &path, const QImage &image, const QByteArray &digest);
+  // The key identical images share. Unlike the rest of the cache, safe to call from any thread.
+  static QByteArray Digest(const QImage &image);
+  // Images computed from a file (e.g. with a color keyed out), kept in the image tier under a key naming the file and
+  // whatever was done to it. Derived returns a null image unless one was inserted under the key.
+  static QImage Derived(const QString &key);
+  static void InsertDerived(const QString &key, const QImage &image);
+  // The hash of the pixels of the image last read from the path, or an empty array if it hasn't been read.
+  static QByteArray DigestOf(const QString &path) { return _digests.value(path); }
+  // Forgets everything, e.g. when the project whose files were cached is closed. Statistics are kept.
+  static void Clear();
+
+  static void SetBudgets(qint64 imageBytes, qint64 pixmapBytes);
+  static Stats GetStats();
+  static QString StatsSummary();
+
+ private:
+  struct Content {
+    QImage image;
+    int users = 0;
+  };
+
+  // Files the image under the path, sharing the cached copy if an identical image is already there.
+  static QImage Adopt(const QString &path, QImage image, const QByteArray &digest);
+  static void Release(const QByteArray &digest);
+  static void EvictImages();
+  static void EvictPixmaps();
+
+  // Decoded images by content, and the LRU of file paths referring to them (most recent first).
+  static QHash<QByteArray, Content> _contents;
+  static std::list<QString> _imageOrder;
+  static QHash<QString, std::pair<QByteArray, std::list<QString>::iterator>> _images;
+  // Outlives the image tier so a pixmap hit doesn't need the image to still be around.
+  static QHash<QString, QByteArray> _digests;
+  static std::list<QByteArray> _pixmapOrder;
+  static QHash<QByteArray, std::pair<QPixmap, std::list<QByteArray>::iterator>> _pixmaps;
+  static qint64 _imageBudget;
+  static qint64 _pixmapBudget;
+  static Stats _stats;
+};
+
+#endif  // IMAGECACHE_H
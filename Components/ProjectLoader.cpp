@@ -0,0 +1,54 @@
+#include "ProjectLoader.h"
+
+#include "egm.h"
+
+#include <QThread>
+
+class ProjectLoader::Worker : public QThread {
+ public:
+  explicit Worker(const QString &fileName) : fileName(fileName) {}
+
+  const QString fileName;
+  // Written by the worker thread only; read back on the GUI thread once it has finished.
+  std::unique_ptr<buffers::Project> project;
+
+ protected:
+  void run() override { project = egm::LoadProject(fileName.toStdString()); }
+};
+
+ProjectLoader::ProjectLoader(QObject *parent) : QObject(parent) {}
+
+ProjectLoader::~ProjectLoader() {
+  // A QThread can't be destroyed while it runs; there is nothing to interrupt, so wait out any parse in flight.
+  for (Worker *worker : qAsConst(_workers)) {
+    worker->disconnect(this);
+    worker->wait();
+    delete worker;
+  }
+}
+
+void ProjectLoader::Load(const QString &fileName) {
+  Cancel();
+  Worker *worker = new Worker(fileName);
+  _current = worker;
+  _workers.insert(worker);
+  // The worker lives on this thread, so finished() is queued back to us.
+  connect(worker, &QThread::finished, this, [this, worker]() { Finished(worker); });
+  worker->start();
+}
+
+void ProjectLoader::Cancel() { _current = nullptr; }
+
+void ProjectLoader::Finished(Worker *worker) {
+  _workers.remove(worker);
+  worker->deleteLater();
+  if (worker != _current) return;  // Abandoned; its project goes down with it.
+  _current = nullptr;
+
+  if (!worker->project) {
+    emit Failed(worker->fileName);
+    return;
+  }
+  _project = std::move(worker->project);
+  emit Loaded(worker->fileName);
+}
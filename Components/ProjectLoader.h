@@ -0,0 +1,43 @@
+#ifndef PROJECTLOADER_H
+#define PROJECTLOADER_H
+
+#include "project.pb.h"
+
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+#include <memory>
+
+// Parses project files on a worker thread so the editor keeps painting and responding while large projects load.
+// Only one load is current at a time; starting another one, or cancelling, abandons it. The parser itself can't be
+// interrupted, so an abandoned load runs to completion in the background and its result is thrown away.
+class ProjectLoader : public QObject {
+  Q_OBJECT
+
+ public:
+  explicit ProjectLoader(QObject *parent = nullptr);
+  ~ProjectLoader();
+
+  void Load(const QString &fileName);
+  void Cancel();
+  bool IsLoading() const { return _current != nullptr; }
+
+  // Hands over the project parsed by the load that just finished. Only meaningful from a Loaded handler.
+  std::unique_ptr<buffers::Project> TakeProject() { return std::move(_project); }
+
+ signals:
+  void Loaded(const QString &fileName);
+  void Failed(const QString &fileName);
+
+ private:
+  class Worker;
+
+  void Finished(Worker *worker);
+
+  Worker *_current = nullptr;
+  QSet<Worker *> _workers;
+  std::unique_ptr<buffers::Project> _project;
+};
+
+#endif  // PROJECTLOADER_H
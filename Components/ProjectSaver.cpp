@@ -0,0 +1,156 @@
+#include "ProjectSaver.h"
+
+#include "egm.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <filesystem>
+
+namespace {
+
+QByteArray HashFile(const QString &path) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) return {};
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  hash.addData(&file);
+  return hash.result();
+}
+
+}  // namespace
+
+void ProjectSnapshot::Assemble() {
+  for (auto &resource : resources) *resource.first = *resource.second;
+  resources.clear();
+}
+
+class ProjectSaver::Worker : public QThread {
+ public:
+  Worker(ProjectSnapshot snapshot, const QString &fileName, QHash<QString, QByteArray> manifest)
+      : fileName(fileName), manifest(std::move(manifest)), _snapshot(std::move(snapshot)) {}
+
+  const QString fileName;
+  // Everything below is written by the worker thread only and read back once it has finished.
+  QHash<QString, QByteArray> manifest;
+  QString error;
+  int written = 0;
+  int unchanged = 0;
+
+ protected:
+  void run() override {
+    const QFileInfo target(fileName);
+    const QDir targetDir = target.absoluteDir();
+    // Staged beside the target so that the final renames never cross a file system.
+    QTemporaryDir staging(targetDir.filePath(".rgm-save-XXXXXX"));
+    if (!staging.isValid()) {
+      error = staging.errorString();
+      return;
+    }
+    _snapshot.Assemble();
+    if (!egm::WriteProject(_snapshot.project.get(), QDir(staging.path()).filePath(target.fileName()).toStdString())) {
+      error = QObject::tr("The project could not be serialized.");
+      return;
+    }
+
+    QSet<QString> produced;
+    QDirIterator it(staging.path(), QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+      const QString staged = it.next();
+      const QString destination = targetDir.filePath(QDir(staging.path()).relativeFilePath(staged));
+      produced.insert(destination);
+      const QByteArray hash = HashFile(staged);
+      // Without a record of the last save, fall back to whatever is on disk.
+      auto known = manifest.constFind(destination);
+      const QByteArray previous = known != manifest.constEnd() ? *known : HashFile(destination);
+      if (!hash.isEmpty() && hash == previous && QFileInfo::exists(destination)) {
+        manifest.insert(destination, hash);
+        ++unchanged;
+        continue;
+      }
+
+      std::error_code ec;
+      if (!targetDir.mkpath(QFileInfo(destination).absolutePath())) {
+        error = QObject::tr("Could not create directory for %1").arg(destination);
+        return;
+      }
+      // Replaces the destination in one step, so readers see either the old file or the new one.
+      std::filesystem::rename(staged.toStdString(), destination.toStdString(), ec);
+      if (ec) {
+        error = QObject::tr("Could not write %1: %2").arg(destination, QString::fromStdString(ec.message()));
+        return;
+      }
+      manifest.insert(destination, hash);
+      ++written;
+    }
+
+    // Only files a previous save wrote are candidates, so nothing else sharing the directory is touched.
+    for (auto entry = manifest.begin(); entry != manifest.end();) {
+      if (produced.contains(entry.key())) {
+        ++entry;
+        continue;
+      }
+      if (QFile::exists(entry.key()) && !QFile::remove(entry.key())) {
+        ++entry;  // Kept, so that the next save tries again.
+        continue;
+      }
+      // Drops directories left empty, such as that of a deleted room, up to the project's own.
+      const QString dir = targetDir.relativeFilePath(QFileInfo(entry.key()).absolutePath());
+      if (dir != "." && !dir.startsWith("..")) targetDir.rmpath(dir);
+      entry = manifest.erase(entry);
+    }
+  }
+
+ private:
+  ProjectSnapshot _snapshot;
+};
+
+ProjectSaver::ProjectSaver(QObject *parent) : QObject(parent) {}
+
+ProjectSaver::~ProjectSaver() {
+  // Let the save in flight finish; abandoning it halfway would leave the project half written.
+  if (_current) {
+    _current->disconnect(this);
+    _current->wait();
+    delete _current;
+  }
+}
+
+void ProjectSaver::Save(ProjectSnapshot snapshot, const QString &fileName) {
+  if (_current) {
+    _pending = std::move(snapshot);
+    _pendingFileName = fileName;
+    return;
+  }
+  Start(std::move(snapshot), fileName);
+}
+
+void ProjectSaver::Start(ProjectSnapshot snapshot, const QString &fileName) {
+  // What was saved elsewhere says nothing about this target, and must not be cleaned out of it.
+  Worker *worker = new Worker(std::move(snapshot), fileName,
+                              fileName == _manifestFile ? _manifest : QHash<QString, QByteArray>());
+  _current = worker;
+  // The worker lives on this thread, so finished() is queued back to us.
+  connect(worker, &QThread::finished, this, [this, worker]() { Finished(worker); });
+  worker->start();
+}
+
+void ProjectSaver::Finished(Worker *worker) {
+  _current = nullptr;
+  worker->deleteLater();
+  // Files moved before a failure are on disk all the same, so the manifest is kept either way.
+  _manifest = std::move(worker->manifest);
+  _manifestFile = worker->fileName;
+  if (worker->error.isEmpty()) {
+    emit Saved(worker->fileName, worker->written, worker->unchanged);
+  } else {
+    emit Failed(worker->fileName, worker->error);
+  }
+
+  if (_pending.project) Start(std::move(_pending), _pendingFileName);
+}
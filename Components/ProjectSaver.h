@@ -0,0 +1,67 @@
+#ifndef PROJECTSAVER_H
+#define PROJECTSAVER_H
+
+#include "project.pb.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QString>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+// A project as it was when a save was requested. The resources are shared rather than copied, so taking one costs
+// little more than the resources edited since the last save (see SnapshotCache); the saving thread puts the pieces
+// back together.
+struct ProjectSnapshot {
+  // Everything but the resources themselves, which are left as empty nodes.
+  std::unique_ptr<buffers::Project> project;
+  // The empty nodes of `project` and the resource each is to be filled in with. The copies are never modified.
+  std::vector<std::pair<buffers::TreeNode *, std::shared_ptr<const buffers::TreeNode>>> resources;
+
+  // Fills in the resources. Only the saving thread calls this.
+  void Assemble();
+};
+
+// Writes EGM projects on a worker thread from a snapshot taken when the save was requested, so editing carries on
+// while the files are written. The project is serialized into a staging directory beside the target, and only files
+// whose contents differ from what was last saved there are moved into place; each move is an atomic rename. Files
+// the last save to the same target wrote but this one no longer does (e.g. of deleted or renamed resources) are
+// removed afterward.
+// Saves never overlap: one requested while another is running waits for it, and only the newest waiting one is kept.
+class ProjectSaver : public QObject {
+  Q_OBJECT
+
+ public:
+  explicit ProjectSaver(QObject *parent = nullptr);
+  ~ProjectSaver();
+
+  void Save(ProjectSnapshot snapshot, const QString &fileName);
+  bool IsSaving() const { return _current != nullptr; }
+  // Forgets what is known to be on disk; for when a different project is opened.
+  void Reset() {
+    _manifest.clear();
+    _manifestFile.clear();
+  }
+
+ signals:
+  void Saved(const QString &fileName, int filesWritten, int filesUnchanged);
+  void Failed(const QString &fileName, const QString &error);
+
+ private:
+  class Worker;
+
+  void Start(ProjectSnapshot snapshot, const QString &fileName);
+  void Finished(Worker *worker);
+
+  Worker *_current = nullptr;
+  ProjectSnapshot _pending;
+  QString _pendingFileName;
+  // Content hashes of every file written by the last save, by absolute path, and the project file it saved to.
+  QHash<QString, QByteArray> _manifest;
+  QString _manifestFile;
+};
+
+#endif  // PROJECTSAVER_H
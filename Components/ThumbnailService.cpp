@@ -0,0 +1,142 @@
+#include "ThumbnailService.h"
+#include "ArtManager.h"
+#include "ThumbnailStore.h"
+
+#include <QImageReader>
+#include <QPainter>
+#include <QRunnable>
+#include <QTimer>
+
+namespace {
+
+// Every size a view asks for; the largest is decoded (or found in the store) and the rest are scaled from it.
+constexpr int kThumbnailSizes[] = {ThumbnailStore::kSize, 64, 32, 16};
+
+QVector<QImage> DecodeThumbnails(const QString &file) {
+  QVector<QImage> images;
+  QImage image;
+  // A stored thumbnail is already at the largest size, and saves opening the file at all.
+  if (!ThumbnailStore::Instance()->Find(file, &image)) {
+    QImageReader reader(file);
+    const QSize size = reader.size();
+    const int largest = kThumbnailSizes[0];
+    if (size.isValid() && (size.width() > largest || size.height() > largest)) {
+      reader.setScaledSize(size.scaled(largest, largest, Qt::KeepAspectRatio));
+    }
+    image = reader.read();
+    ThumbnailStore::Instance()->Put(file, image);
+  }
+  if (image.isNull()) return images;
+  images.append(image);
+  for (int target : kThumbnailSizes) {
+    if (image.width() <= target && image.height() <= target) continue;
+    image = image.scaled(target, target, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    images.append(image);
+  }
+  return images;
+}
+
+}  // namespace
+
+class ThumbnailService::Task : public QRunnable {
+ public:
+  Task(ThumbnailService *service, const QString &file, int generation)
+      : _service(service), _file(file), _generation(generation) {}
+
+  void run() override {
+    const QVector<QImage> images = DecodeThumbnails(_file);
+    ThumbnailService *service = _service;
+    const QString file = _file;
+    const int generation = _generation;
+    QMetaObject::invokeMethod(
+        service, [service, file, generation, images]() { service->Finished(file, generation, images); },
+        Qt::QueuedConnection);
+  }
+
+ private:
+  ThumbnailService *_service;
+  QString _file;
+  int _generation;
+};
+
+ThumbnailService *ThumbnailService::Instance() {
+  // Lives as long as the application; its tasks may still report back during shutdown.
+  static ThumbnailService *service = new ThumbnailService();
+  return service;
+}
+
+ThumbnailService::ThumbnailService() : _placeholder(16, 16) {
+  _placeholder.fill(Qt::transparent);
+  QPainter painter(&_placeholder);
+  painter.fillRect(_placeholder.rect(), ArtManager::GetTransparenyBrush());
+}
+
+QIcon ThumbnailService::Icon(const QString &file) {
+  ThumbnailService *service = Instance();
+  auto it = service->_icons.constFind(file);
+  if (it != service->_icons.constEnd()) return *it;
+  if (file.isEmpty()) return {};
+  // The icons share the pixmap, but each has a cache key of its own.
+  const QIcon placeholder(service->_placeholder);
+  service->_icons.insert(file, placeholder);
+  service->_files.insert(placeholder.cacheKey(), file);
+  service->_placeholders.insert(placeholder.cacheKey());
+  service->Start(file);
+  return placeholder;
+}
+
+bool ThumbnailService::IsPlaceholder(const QIcon &icon) { return Instance()->_placeholders.contains(icon.cacheKey()); }
+
+QString ThumbnailService::FileOf(const QIcon &icon) { return Instance()->_files.value(icon.cacheKey()); }
+
+void ThumbnailService::Rebuild() {
+  ThumbnailService *service = Instance();
+  ThumbnailStore::Instance()->Clear();
+  // Icons already handed out stay up until their replacements are in.
+  for (auto it = service->_icons.cbegin(); it != service->_icons.cend(); ++it) service->Start(it.key());
+}
+
+void ThumbnailService::Clear() {
+  ThumbnailService *service = Instance();
+  service->_icons.clear();
+  service->_files.clear();
+  service->_placeholders.clear();
+  service->_pending.clear();
+  service->_ready.clear();
+  ++service->_generation;
+}
+
+void ThumbnailService::Start(const QString &file) {
+  if (_pending.contains(file)) return;
+  _pending.insert(file);
+  _pool.start(new Task(this, file, _generation));
+}
+
+void ThumbnailService::Finished(const QString &file, int generation, const QVector<QImage> &images) {
+  if (generation != _generation) return;
+  _pending.remove(file);
+  QIcon icon;
+  for (const QImage &image : images) {
+    if (!image.isNull()) icon.addPixmap(QPixmap::fromImage(image));
+  }
+  // A file which can't be read gets no icon, rather than a placeholder forever.
+  if (auto old = _icons.constFind(file); old != _icons.constEnd()) {
+    _files.remove(old->cacheKey());
+    _placeholders.remove(old->cacheKey());
+  }
+  if (!icon.isNull()) _files.insert(icon.cacheKey(), file);
+  _icons.insert(file, icon);
+  _ready.insert(file);
+  NotifyReady();
+}
+
+void ThumbnailService::NotifyReady() {
+  if (_notifyQueued) return;
+  _notifyQueued = true;
+  QTimer::singleShot(0, this, [this]() {
+    _notifyQueued = false;
+    QSet<QString> ready;
+    ready.swap(_ready);
+    emit ThumbnailsReady(ready);
+  });
+}
@@ -0,0 +1,59 @@
+#ifndef THUMBNAILSERVICE_H
+#define THUMBNAILSERVICE_H
+
+#include <QHash>
+#include <QIcon>
+#include <QImage>
+#include <QObject>
+#include <QPixmap>
+#include <QSet>
+#include <QThreadPool>
+#include <QVector>
+
+// Icons previewing image files (sprite subimages, backgrounds), decoded and scaled down on a thread pool so that
+// views never wait on the disk. Until a file's thumbnail is ready its icon is a placeholder; ThumbnailsReady fires
+// (at most once per pass of the event loop) when some have finished, so views can ask again.
+class ThumbnailService : public QObject {
+  Q_OBJECT
+
+ public:
+  static ThumbnailService *Instance();
+
+  static QIcon Icon(const QString &file);
+  static bool IsPlaceholder(const QIcon &icon);
+  // The file a thumbnail or placeholder handed out by Icon() previews; empty for any other icon.
+  static QString FileOf(const QIcon &icon);
+  // Throws away the on-disk store (see ThumbnailStore) and decodes every thumbnail handed out so far again.
+  static void Rebuild();
+  // Forgets every thumbnail handed out so far, e.g. when the project they belong to is closed. Decodes still running
+  // are dropped when they finish.
+  static void Clear();
+
+ signals:
+  // The files whose thumbnails finished since the last notification, including ones replaced by Rebuild().
+  void ThumbnailsReady(const QSet<QString> &files);
+
+ private:
+  class Task;
+
+  ThumbnailService();
+  void Start(const QString &file);
+  void Finished(const QString &file, int generation, const QVector<QImage> &images);
+  void NotifyReady();
+
+  QThreadPool _pool;
+  // Thumbnails by file, and placeholders for the files still being decoded.
+  QHash<QString, QIcon> _icons;
+  QSet<QString> _pending;
+  QSet<QString> _ready;
+  // The file behind each icon in _icons, by cache key.
+  QHash<qint64, QString> _files;
+  // Each pending file gets its own icon showing this, so that FileOf() can tell which file it is waiting on.
+  QPixmap _placeholder;
+  QSet<qint64> _placeholders;
+  // Bumped by Clear(), so that decodes started before it can be told apart.
+  int _generation = 0;
+  bool _notifyQueued = false;
+};
+
+#endif  // THUMBNAILSERVICE_H
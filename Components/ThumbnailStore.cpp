@@ -0,0 +1,229 @@
+#include "ThumbnailStore.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr char kMagic[4] = {'R', 'G', 'M', 'T'};
+// Version 2 stores thumbnails of up to 128 pixels rather than 64; older packs are dropped.
+constexpr quint32 kVersion = 2;
+constexpr qint64 kBudgetBytes = 128 * 1024 * 1024;
+constexpr qint64 kMaxAgeSecs = 90 * 24 * 60 * 60;
+constexpr int kKeySize = 20;  // SHA1
+
+// The pack is a header, then one record per thumbnail, then the pixels (ARGB32 premultiplied, tightly packed) that
+// the records point to. It never leaves this machine, so everything is in native byte order.
+struct PackHeader {
+  char magic[4];
+  quint32 version;
+  quint32 count;
+  quint32 reserved;
+};
+
+struct PackRecord {
+  char key[kKeySize];
+  quint32 width;
+  quint32 height;
+  quint32 reserved;
+  quint64 offset;
+  qint64 last_used;
+};
+
+static_assert(sizeof(PackHeader) == 16, "Pack header must not be padded");
+static_assert(sizeof(PackRecord) == 48, "Pack records must not be padded");
+
+qint64 PixelBytes(int width, int height) { return qint64(width) * height * 4; }
+
+}  // namespace
+
+ThumbnailStore *ThumbnailStore::Instance() {
+  static ThumbnailStore *store = new ThumbnailStore();
+  return store;
+}
+
+ThumbnailStore::ThumbnailStore() {
+  _pack.setFileName(PackPath());
+  Map();
+  if (auto *app = QCoreApplication::instance()) {
+    QObject::connect(app, &QCoreApplication::aboutToQuit, [this]() { Flush(); });
+  }
+}
+
+QString ThumbnailStore::PackPath() {
+  return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/thumbnails.pack";
+}
+
+QByteArray ThumbnailStore::Key(const QString &file) {
+  const QFileInfo info(file);
+  if (!info.exists()) return {};
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  hash.addData(info.absoluteFilePath().toUtf8());
+  const qint64 stamp[] = {info.size(), info.lastModified().toMSecsSinceEpoch()};
+  hash.addData(reinterpret_cast<const char *>(stamp), sizeof(stamp));
+  return hash.result();
+}
+
+bool ThumbnailStore::Map() {
+  if (!_pack.exists() || !_pack.open(QIODevice::ReadWrite)) return false;
+  const qint64 size = _pack.size();
+  if (size >= qint64(sizeof(PackHeader))) _mapped = _pack.map(0, size);
+  if (!_mapped) {
+    _pack.close();
+    return false;
+  }
+  _mappedSize = size;
+
+  const auto *header = reinterpret_cast<const PackHeader *>(_mapped);
+  const qint64 indexEnd = sizeof(PackHeader) + qint64(header->count) * sizeof(PackRecord);
+  if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion || indexEnd > size) {
+    qDebug() << "Ignoring unrecognized thumbnail pack" << _pack.fileName();
+    Unmap();
+    return false;
+  }
+  const auto *records = reinterpret_cast<const PackRecord *>(_mapped + sizeof(PackHeader));
+  for (quint32 i = 0; i < header->count; ++i) {
+    const PackRecord &record = records[i];
+    if (qint64(record.offset) + PixelBytes(record.width, record.height) > size) continue;
+    _entries[QByteArray(record.key, kKeySize)].record = i;
+  }
+  return true;
+}
+
+void ThumbnailStore::Unmap() {
+  if (_mapped) _pack.unmap(_mapped);
+  _mapped = nullptr;
+  _mappedSize = 0;
+  _pack.close();
+  _entries.clear();
+}
+
+bool ThumbnailStore::Find(const QString &file, QImage *image) {
+  const QByteArray key = Key(file);
+  if (key.isEmpty()) return false;
+  QMutexLocker lock(&_mutex);
+  auto it = _entries.find(key);
+  if (it == _entries.end()) return false;
+  if (!it->image.isNull()) {
+    *image = it->image;
+    return true;
+  }
+  auto *record = reinterpret_cast<PackRecord *>(_mapped + sizeof(PackHeader)) + it->record;
+  // Written straight through the mapping, so recency survives without rewriting the pack.
+  record->last_used = QDateTime::currentSecsSinceEpoch();
+  // Copied out, since the mapping is replaced on the next flush.
+  *image = QImage(_mapped + record->offset, record->width, record->height, record->width * 4,
+                  QImage::Format_ARGB32_Premultiplied)
+               .copy();
+  return true;
+}
+
+void ThumbnailStore::Put(const QString &file, const QImage &image) {
+  if (image.isNull()) return;
+  const QByteArray key = Key(file);
+  if (key.isEmpty()) return;
+  QImage thumbnail = image;
+  if (thumbnail.width() > kSize || thumbnail.height() > kSize) {
+    thumbnail = thumbnail.scaled(kSize, kSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+  }
+  thumbnail = thumbnail.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+  QMutexLocker lock(&_mutex);
+  Entry &entry = _entries[key];
+  entry.record = -1;
+  entry.image = thumbnail;
+  _dirty = true;
+}
+
+void ThumbnailStore::Flush() {
+  QMutexLocker lock(&_mutex);
+  if (!_dirty) return;
+
+  struct Pending {
+    QByteArray key;
+    const Entry *entry;
+    int width, height;
+    qint64 lastUsed;
+  };
+  const qint64 now = QDateTime::currentSecsSinceEpoch();
+  std::vector<Pending> pending;
+  pending.reserve(_entries.size());
+  const auto *records = reinterpret_cast<const PackRecord *>(_mapped + sizeof(PackHeader));
+  for (auto it = _entries.cbegin(); it != _entries.cend(); ++it) {
+    if (!it->image.isNull()) {
+      pending.push_back({it.key(), &*it, it->image.width(), it->image.height(), now});
+    } else {
+      const PackRecord &record = records[it->record];
+      if (now - record.last_used > kMaxAgeSecs) continue;
+      pending.push_back({it.key(), &*it, int(record.width), int(record.height), record.last_used});
+    }
+  }
+  // Most recently used first, so that whatever doesn't fit the budget is the stalest.
+  std::sort(pending.begin(), pending.end(),
+            [](const Pending &a, const Pending &b) { return a.lastUsed > b.lastUsed; });
+  qint64 bytes = 0;
+  std::size_t kept = 0;
+  while (kept < pending.size() && bytes + PixelBytes(pending[kept].width, pending[kept].height) <= kBudgetBytes) {
+    bytes += PixelBytes(pending[kept].width, pending[kept].height);
+    ++kept;
+  }
+  pending.resize(kept);
+
+  QDir().mkpath(QFileInfo(PackPath()).absolutePath());
+  QSaveFile out(PackPath());
+  if (!out.open(QIODevice::WriteOnly)) {
+    qDebug() << "Failed to write thumbnail pack" << out.fileName() << out.errorString();
+    return;
+  }
+  PackHeader header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.count = pending.size();
+  header.reserved = 0;
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  quint64 offset = sizeof(PackHeader) + pending.size() * sizeof(PackRecord);
+  for (const Pending &p : pending) {
+    PackRecord record;
+    std::memcpy(record.key, p.key.constData(), kKeySize);
+    record.width = p.width;
+    record.height = p.height;
+    record.reserved = 0;
+    record.offset = offset;
+    record.last_used = p.lastUsed;
+    out.write(reinterpret_cast<const char *>(&record), sizeof(record));
+    offset += PixelBytes(p.width, p.height);
+  }
+  for (const Pending &p : pending) {
+    if (!p.entry->image.isNull()) {
+      for (int y = 0; y < p.height; ++y) {
+        out.write(reinterpret_cast<const char *>(p.entry->image.constScanLine(y)), PixelBytes(p.width, 1));
+      }
+    } else {
+      out.write(reinterpret_cast<const char *>(_mapped + records[p.entry->record].offset),
+                PixelBytes(p.width, p.height));
+    }
+  }
+
+  // The old mapping has to go before the new file can take its place.
+  Unmap();
+  if (!out.commit()) qDebug() << "Failed to replace thumbnail pack" << out.fileName() << out.errorString();
+  _dirty = false;
+  Map();
+}
+
+void ThumbnailStore::Clear() {
+  QMutexLocker lock(&_mutex);
+  Unmap();
+  _pack.remove();
+  _dirty = false;
+}
@@ -0,0 +1,55 @@
+#ifndef THUMBNAILSTORE_H
+#define THUMBNAILSTORE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+
+// Thumbnails kept on disk between sessions, so that a cold start can fill the resource tree without reading the
+// original images. Everything lives in one pack file in the user's cache directory, which is memory mapped while the
+// editor runs: lookups copy the pixels straight out of the mapping. Thumbnails are keyed by the file's path, size and
+// modification time, so an edited image simply misses.
+//
+// New thumbnails are held in memory and written out by Flush (on exit), which also evicts the least recently used
+// entries once the pack outgrows its budget, and anything left unused for a few months.
+// Safe to use from any thread.
+class ThumbnailStore {
+ public:
+  // Largest side of a stored thumbnail; bigger images are scaled down on the way in. This is the largest size
+  // ThumbnailService hands out, so a hit can serve every size without reading the file.
+  static constexpr int kSize = 128;
+
+  static ThumbnailStore *Instance();
+
+  bool Find(const QString &file, QImage *image);
+  void Put(const QString &file, const QImage &image);
+  void Flush();
+  // Deletes the pack file and forgets everything in it.
+  void Clear();
+
+  static QString PackPath();
+
+ private:
+  // Location of a thumbnail inside the mapped pack, or the thumbnail itself if it hasn't been written yet.
+  struct Entry {
+    qint64 record = -1;
+    QImage image;
+  };
+
+  ThumbnailStore();
+  bool Map();
+  void Unmap();
+  static QByteArray Key(const QString &file);
+
+  QMutex _mutex;
+  QFile _pack;
+  uchar *_mapped = nullptr;
+  qint64 _mappedSize = 0;
+  QHash<QByteArray, Entry> _entries;
+  bool _dirty = false;
+};
+
+#endif  // THUMBNAILSTORE_H
@@ -1,4 +1,6 @@
 #include "BaseEditor.h"
+#include "Components/Logger.h"
+#include "Models/ChangeJournal.h"
 #include "Models/MessageModel.h"
 
 #include <QCloseEvent>
@@ -9,8 +11,8 @@ BaseEditor::BaseEditor(MessageModel* resource_model, QWidget* parent)
     : QWidget(parent), _model(resource_model->GetParentModel<MessageModel>()), _nodeMapper(new ModelMapper(_model, this)) {
   _resMapper = new ModelMapper(resource_model, this);
 
-  // Backup should be deleted by Qt's garbage collector when this editor is closed
-  _resMapper->GetModel()->BackupModel(this);
+  // Journal should be deleted by Qt's garbage collector when this editor is closed
+  _resMapper->GetModel()->StartJournal(this);
 
   connect(_model, &QAbstractItemModel::modelReset, [this]() { this->RebindSubModels(); });
 }
@@ -44,6 +46,29 @@ void BaseEditor::closeEvent(QCloseEvent* event) {
   event->accept();
 }
 
+void BaseEditor::AddUndoActions(QAction* undo, QAction* redo) {
+  ChangeJournal* journal = _resMapper->GetModel()->GetJournal();
+  R_EXPECT_V(journal) << "Editor has no change journal";
+  if (!undo) undo = new QAction(tr("Undo"), this);
+  if (!redo) redo = new QAction(tr("Redo"), this);
+  // Scoped to this editor so several open editors don't fight over the shortcut.
+  for (QAction* action : {undo, redo}) {
+    action->setShortcutContext(Qt::WidgetWithChildrenShortcut);
+    addAction(action);
+  }
+  undo->setShortcut(QKeySequence::Undo);
+  redo->setShortcut(QKeySequence::Redo);
+  connect(undo, &QAction::triggered, journal, &ChangeJournal::Undo);
+  connect(redo, &QAction::triggered, journal, &ChangeJournal::Redo);
+
+  auto updateActions = [=]() {
+    undo->setEnabled(journal->CanUndo());
+    redo->setEnabled(journal->CanRedo());
+  };
+  connect(journal, &ChangeJournal::HistoryChanged, this, updateActions);
+  updateActions();
+}
+
 void BaseEditor::ReplaceBuffer(google::protobuf::Message* buffer) { _resMapper->ReplaceBuffer(buffer); }
 
 void BaseEditor::dataChanged(const QModelIndex& /*topLeft*/, const QModelIndex& /*bottomRight*/, const QVariant& /*oldValue*/,
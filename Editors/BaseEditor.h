@@ -4,6 +4,7 @@
 #include "Models/MessageModel.h"
 #include "Models/ModelMapper.h"
 
+#include <QAction>
 #include <QObject>
 #include <QWidget>
 
@@ -32,6 +33,8 @@ class BaseEditor : public QWidget {
 
  protected:
   virtual void closeEvent(QCloseEvent *event) override;
+  // Binds undo/redo to the resource's change journal, creating the actions if none are given.
+  void AddUndoActions(QAction *undo = nullptr, QAction *redo = nullptr);
 
   bool _reset_model_on_close = false;
   bool _deleted = false;
@@ -25,6 +25,7 @@ ObjectEditor::ObjectEditor(MessageModel *model, QWidget *parent)
   _nodeMapper->addMapping(_ui->nameEdit, TreeNode::kNameFieldNumber);
 
   connect(_ui->saveButton, &QAbstractButton::pressed, this, &BaseEditor::OnSave);
+  AddUndoActions();
 
   _eventsModel = new EventsListModel(MainWindow::GetEventData(), this);
 
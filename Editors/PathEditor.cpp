@@ -13,6 +13,7 @@
 PathEditor::PathEditor(MessageModel* model, QWidget* parent) : BaseEditor(model, parent), _ui(new Ui::PathEditor) {
   _ui->setupUi(this);
   connect(_ui->saveButton, &QAbstractButton::pressed, this, &BaseEditor::OnSave);
+  AddUndoActions();
 
   _ui->pathPreviewBackground->SetAssetView(_ui->roomView);
 
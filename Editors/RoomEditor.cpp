@@ -23,6 +23,7 @@ using View = buffers::resources::Room::View;
 RoomEditor::RoomEditor(MessageModel* model, QWidget* parent) : BaseEditor(model, parent), _ui(new Ui::RoomEditor) {
   _ui->setupUi(this);
   connect(_ui->actionSave, &QAction::triggered, this, &BaseEditor::OnSave);
+  AddUndoActions(_ui->actionUndo, _ui->actionRedo);
 
   _ui->roomPreviewBackground->SetAssetView(_ui->roomView);
 
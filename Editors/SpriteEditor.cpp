@@ -20,6 +20,7 @@ SpriteEditor::SpriteEditor(MessageModel* model, QWidget* parent)
     : BaseEditor(model, parent), _ui(new Ui::SpriteEditor) {
   _ui->setupUi(this);
   connect(_ui->actionSave, &QAction::triggered, this, &BaseEditor::OnSave);
+  AddUndoActions();
   _ui->scrollAreaWidget->SetAssetView(_ui->subimagePreview);
 
   QCheckBox* showBBox = new QCheckBox(tr("Show BBox"), this);
@@ -64,6 +65,7 @@ void SpriteEditor::RebindSubModels() {
           &SpriteEditor::SelectionChanged);
 
   connect(_subimagesModel, &QAbstractItemModel::modelReset, this, &SpriteEditor::SubImagesRemoved);
+  connect(_subimagesModel, &QAbstractItemModel::rowsRemoved, this, &SpriteEditor::SubImagesRemoved);
 
   BaseEditor::RebindSubModels();
 
@@ -167,20 +169,21 @@ void SpriteEditor::on_actionLoadSubimages_triggered() {
     if (img.size().width() > 0 && img.size().height() > 0) {
       _subimagesModel->Clear();
       auto const selected = dialog->selectedFiles();
+      QVariantList subimages;
       for (const QString& fName : selected) {
         QImageReader newImg(fName);
         if (img.size() == newImg.size()) {
-          _subimagesModel->insertRow(_subimagesModel->rowCount());
           // TODO: Internalize file
-          _subimagesModel->SetDataAtRow(_subimagesModel->rowCount() - 1, fName);
-          _ui->subimagePreview->SetSubimage(0);
-          // Redo BBox
-          on_bboxComboBox_currentIndexChanged(
-              _spriteModel->Data(FieldPath::Of<Sprite>(Sprite::kBboxModeFieldNumber)).toInt());
+          subimages.append(fName);
         } else {
           LoadedMismatchedImage(img.size(), newImg.size());
         }
       }
+      _subimagesModel->InsertRange(0, subimages);
+      _ui->subimagePreview->SetSubimage(0);
+      // Redo BBox
+      on_bboxComboBox_currentIndexChanged(
+          _spriteModel->Data(FieldPath::Of<Sprite>(Sprite::kBboxModeFieldNumber)).toInt());
     } else {
       qDebug() << " Failed to load image: " << dialog->selectedFiles().at(0);
     }
@@ -195,18 +198,17 @@ void SpriteEditor::on_actionAddSubimages_triggered() {
   if (dialog->exec() && dialog->selectedFiles().size() > 0) {
     QSize imgSize = _ui->subimagePreview->GetPixmap().size();
     auto const files = dialog->selectedFiles();
+    QVariantList subimages;
     for (const QString& fName : files) {
       QImageReader newImg(fName);
       if (imgSize == newImg.size()) {
-        _subimagesModel->insertRow(_subimagesModel->rowCount());
         // TODO: Internalize file
-        _subimagesModel->SetData(FieldPath::Of<Sprite>(FieldPath::StartingAt(_subimagesModel->rowCount() - 1),
-                                                       Sprite::kSubimagesFieldNumber),
-                                 fName);
+        subimages.append(fName);
       } else {
         LoadedMismatchedImage(imgSize, newImg.size());
       }
     }
+    _subimagesModel->InsertRange(_subimagesModel->rowCount(), subimages);
   } else {
     qDebug() << " Failed to load image: " << dialog->selectedFiles().at(0);
   }
@@ -8,6 +8,9 @@
 #include <QMessageBox>
 #include <QPushButton>
 
+// Step of the moment at a given row; resolved once since it's looked up in a loop over every moment.
+using MomentStep = FieldPath::Static<Timeline::Moment, Timeline::Moment::kStepFieldNumber>;
+
 TimelineEditor::TimelineEditor(MessageModel* model, QWidget* parent)
     : BaseEditor(model, parent), _ui(new Ui::TimelineEditor) {
   _ui->setupUi(this);
@@ -15,6 +18,7 @@ TimelineEditor::TimelineEditor(MessageModel* model, QWidget* parent)
   _nodeMapper->addMapping(_ui->nameEdit, TreeNode::kNameFieldNumber);
 
   connect(_ui->saveButton, &QAbstractButton::pressed, this, &BaseEditor::OnSave);
+  AddUndoActions();
 
   connect(_ui->momentsList, &QAbstractItemView::clicked, [=](const QModelIndex& index) {
     SetCurrentEditor(index.row());
@@ -113,11 +117,7 @@ void TimelineEditor::RemoveMoment(int modelIndex) {
 
 int TimelineEditor::FindInsertIndex(int step) {
   int index = 0;
-  while (index < _momentsModel->rowCount() &&
-         step > _momentsModel
-                    ->Data(FieldPath::Of<Timeline::Moment>(FieldPath::StartingAt(index),
-                                                           Timeline::Moment::kStepFieldNumber))
-                    .toInt()) {
+  while (index < _momentsModel->rowCount() && step > _momentsModel->Data(MomentStep(index)).toInt()) {
     ++index;
   }
 
@@ -126,9 +126,7 @@ int TimelineEditor::FindInsertIndex(int step) {
 
 int TimelineEditor::IndexOf(int step) {
   for (int r = 0; r < _momentsModel->rowCount(); ++r) {
-    if (_momentsModel
-            ->Data(FieldPath::Of<Timeline::Moment>(FieldPath::StartingAt(r), Timeline::Moment::kStepFieldNumber))
-            .toInt() == step) {
+    if (_momentsModel->Data(MomentStep(r)).toInt() == step) {
       return r;
     }
   }
@@ -151,9 +149,7 @@ void TimelineEditor::SetCurrentEditor(int modelIndex) {
 
 void TimelineEditor::CheckDisableButtons(int value) {
   for (int i = 0; i < _momentsModel->rowCount(); ++i) {
-    if (_momentsModel
-            ->Data(FieldPath::Of<Timeline::Moment>(FieldPath::StartingAt(i), Timeline::Moment::kStepFieldNumber))
-            .toInt() == value) {
+    if (_momentsModel->Data(MomentStep(i)).toInt() == value) {
       _ui->addMomentButton->setDisabled(true);
       _ui->changeMomentButton->setDisabled(false);
       _ui->deleteMomentButton->setDisabled(false);
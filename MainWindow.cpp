@@ -17,11 +17,19 @@
 #include "Editors/TimelineEditor.h"
 
 #include "Components/ArtManager.h"
+#include "Components/ImageCache.h"
 #include "Components/Logger.h"
+#include "Components/ProjectLoader.h"
+#include "Components/ProjectSaver.h"
+#include "Components/ThumbnailService.h"
+
+#include "Models/SnapshotCache.h"
 
 #include "Plugins/RGMPlugin.h"
 #include "Plugins/ServerPlugin.h"
 
+#include "Widgets/SpriteView.h"
+
 #include "gmk.h"
 #include "gmx.h"
 #include "yyp.h"
@@ -41,6 +49,7 @@ QFileInfo MainWindow::EnigmaRoot = MainWindow::getEnigmaRoot();
 QList<buffers::SystemType> MainWindow::systemCache;
 MainWindow *MainWindow::_instance = nullptr;
 ResourceModelMap *MainWindow::resourceMap = nullptr;
+MessageModel *MainWindow::resourceModel = nullptr;
 TreeModel *MainWindow::treeModel = nullptr;
 std::unique_ptr<EventData> MainWindow::_event_data;
 
@@ -138,6 +147,14 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), _ui(new Ui::MainW
   QToolButton *clearButton = new QToolButton();
   clearButton->setText(tr("Clear"));
   outputTB->addWidget(clearButton);
+  QToolButton *cacheStatsButton = new QToolButton();
+  cacheStatsButton->setText(tr("Image Cache"));
+  cacheStatsButton->setToolTip(tr("Log image cache statistics to the diagnostics output"));
+  outputTB->addWidget(cacheStatsButton);
+  QToolButton *rebuildThumbnailsButton = new QToolButton();
+  rebuildThumbnailsButton->setText(tr("Rebuild Thumbnails"));
+  rebuildThumbnailsButton->setToolTip(tr("Discard the thumbnail cache and decode every thumbnail again"));
+  outputTB->addWidget(rebuildThumbnailsButton);
   QVBoxLayout *outputLayout = static_cast<QVBoxLayout *>(_ui->outputDockWidgetContents->layout());
   outputLayout->insertWidget(0, outputTB);
 
@@ -147,6 +164,11 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), _ui(new Ui::MainW
 
   connect(clearButton, &QToolButton::clicked,
           [=]() { (toggleDiagnosticsAction->isChecked() ? _ui->debugTextBrowser : _ui->outputTextBrowser)->clear(); });
+  connect(cacheStatsButton, &QToolButton::clicked, [=]() {
+    toggleDiagnosticsAction->setChecked(true);
+    qInfo().noquote() << ImageCache::StatsSummary();
+  });
+  connect(rebuildThumbnailsButton, &QToolButton::clicked, &ThumbnailService::Rebuild);
   connect(toggleDiagnosticsAction, &QAction::toggled, [=](bool checked) {
     _ui->outputStackedWidget->setCurrentIndex(checked);
 
@@ -160,6 +182,27 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), _ui(new Ui::MainW
   this->readSettings();
   this->_recentFiles = new RecentFiles(this, this->_ui->menuRecent, this->_ui->actionClearRecentMenu);
 
+  _loader = new ProjectLoader(this);
+  connect(_loader, &ProjectLoader::Loaded, this, &MainWindow::projectLoaded);
+  connect(_loader, &ProjectLoader::Failed, this, [this](const QString &fName) {
+    if (_loadProgress) _loadProgress->reset();
+    QMessageBox::warning(this, tr("Failed To Open Project"), tr("There was a problem loading the project: ") + fName,
+                         QMessageBox::Ok);
+  });
+
+  _saver = new ProjectSaver(this);
+  _snapshots = new SnapshotCache(this);
+  connect(_saver, &ProjectSaver::Saved, this, [this](const QString &fName, int written, int unchanged) {
+    _recentFiles->prependFile(fName);
+    _ui->outputTextBrowser->append(
+        tr("Saved %1 (%2 files written, %3 unchanged)").arg(fName).arg(written).arg(unchanged));
+  });
+  connect(_saver, &ProjectSaver::Failed, this, [this](const QString &fName, const QString &error) {
+    setWindowModified(true);
+    QMessageBox::warning(this, tr("Failed To Save Project"),
+                         tr("There was a problem saving the project: ") + fName + "\n" + error, QMessageBox::Ok);
+  });
+
   _ui->mdiArea->setBackground(QImage(":/banner.png"));
   connect(_ui->menuWindow, &QMenu::aboutToShow, this, &MainWindow::updateWindowMenu);
 
@@ -282,21 +325,37 @@ void MainWindow::updateWindowMenu() {
 void MainWindow::openFile(QString fName) {
   QFileInfo fileInfo(fName);
 
-  std::unique_ptr<buffers::Project> loadedProject = egm::LoadProject(fName.toStdString());
-
-  if (!loadedProject) {
-    QMessageBox::warning(this, tr("Failed To Open Project"), tr("There was a problem loading the project: ") + fName,
-                         QMessageBox::Ok);
-    return;
+  // Parsing happens on a worker thread; the project is handed back through projectLoaded.
+  if (!_loadProgress) {
+    _loadProgress = new QProgressDialog(this);
+    _loadProgress->setWindowModality(Qt::WindowModal);
+    _loadProgress->setWindowTitle(tr("Open Project"));
+    _loadProgress->setRange(0, 0);  // The parser doesn't report progress, so just show that it's busy.
+    _loadProgress->setMinimumDuration(500);
+    connect(_loadProgress, &QProgressDialog::canceled, _loader, &ProjectLoader::Cancel);
   }
+  _loadProgress->setLabelText(tr("Loading %1...").arg(fileInfo.fileName()));
+  _loader->Load(fName);
+  // Only arms the minimum duration timer; the dialog shows itself if the load is slow.
+  _loadProgress->setValue(0);
+}
 
-  MainWindow::setWindowTitle(fileInfo.fileName() + " - ENIGMA");
+void MainWindow::projectLoaded(const QString &fName) {
+  if (_loadProgress) _loadProgress->reset();
+  QFileInfo fileInfo(fName);
+  MainWindow::setWindowTitle(fileInfo.fileName() + "[*] - ENIGMA");
   _recentFiles->prependFile(fName);
-  openProject(std::move(loadedProject));
+  openProject(_loader->TakeProject());
+  // Only EGM can be written back; other formats go through Save As.
+  _projectFile = fileInfo.suffix() == "egm" ? fName : QString();
 }
 
 void MainWindow::openNewProject() {
-  MainWindow::setWindowTitle(tr("<new game> - ENIGMA"));
+  // A project still loading would otherwise replace this one once it arrives.
+  _loader->Cancel();
+  if (_loadProgress) _loadProgress->reset();
+  MainWindow::setWindowTitle(tr("<new game>[*] - ENIGMA"));
+  _projectFile.clear();
   auto newProject = std::make_unique<buffers::Project>();
   auto *root = newProject->mutable_game()->mutable_root();
   QList<QString> defaultGroups = {tr("Sprites"), tr("Sounds"),  tr("Backgrounds"), tr("Paths"),
@@ -360,6 +419,16 @@ void ConfigureIconFields(ProtoModel::DisplayConfig *conf, const Descriptor *desc
 void MainWindow::openProject(std::unique_ptr<buffers::Project> openedProject) {
   this->_ui->mdiArea->closeAllSubWindows();
   ArtManager::clearCache();
+  SpriteView::ClearAutomaticBBoxCache();
+
+  // Editors are torn down asynchronously and restore their backups on the way out, so the old model graph (and the
+  // buffer it points into) is only dropped once they are gone. Its arena is freed in one go after the last model dies.
+  if (resourceModel) {
+    buffers::Project *oldProject = _project.release();
+    connect(resourceModel, &QObject::destroyed, [oldProject]() { delete oldProject; });
+    resourceModel->deleteLater();
+  }
+  ModelArena::Reset();
 
   _project = std::move(openedProject);
 
@@ -420,22 +489,19 @@ void MainWindow::openProject(std::unique_ptr<buffers::Project> openedProject) {
   resourceMap = new ResourceModelMap(this);
 
   auto pm = new MessageModel(ProtoModel::NonProtoParent{this}, _project->mutable_game()->mutable_root());
-
-  // Connect methods to auto update fields with extensions
-  connect(pm, &ProtoModel::ModelConstructed, [](ProtoModel *model) {
-    PrimitiveModel *primitive_model = model->TryCastAsPrimitiveModel();
-    if (primitive_model) {
-      const FieldDescriptor *const field = primitive_model->GetFieldDescriptor();
-      if (field && !field->options().GetExtension(buffers::resource_ref).empty())
-        connect(resourceMap,
-                qOverload<const std::string &, const QString &, const QString &>(&ResourceModelMap::ResourceRenamed),
-                primitive_model,
-                [primitive_model](const std::string &type, const QString &newValue, const QString &oldValue) {
-                  primitive_model->ExtensionChanged<decltype(buffers::resource_ref)>(buffers::resource_ref, type,
-                                                                                     newValue, oldValue);
-                });
-    }
+  resourceModel = pm;
+
+  // Keep the index of fields with resource_ref extensions current, so renames and deletes can find them without a scan
+  connect(pm, &ProtoModel::ResourceReferenceChanged, resourceMap, &ResourceModelMap::ReferenceChanged);
+  connect(pm, &ProtoModel::ResourceReferencesAdded, resourceMap, &ResourceModelMap::ReferencesAdded);
+  // Every edit, including row inserts and removals, is forwarded up to the root as a data change. The check skips
+  // editors of the previous project restoring their backups on the way out.
+  connect(pm, &ProtoModel::DataChanged, this, [this, pm]() {
+    if (pm == resourceModel) setWindowModified(true);
   });
+  setWindowModified(false);
+  _saver->Reset();
+  _snapshots->Clear();
 
   pm->RebuildSubModels();
 
@@ -448,7 +514,7 @@ void MainWindow::openProject(std::unique_ptr<buffers::Project> openedProject) {
   _ui->treeView->setModel(treeModel);
   connect(treeModel, &TreeModel::ItemRenamed, resourceMap,
           qOverload<buffers::TreeNode::TypeCase, const QString &, const QString &>(&ResourceModelMap::ResourceRenamed));
-  connect(treeModel, &TreeModel::TreeChanged, resourceMap, &ResourceModelMap::TreeChanged);
+  resourceMap->TrackTree(treeModel);
   connect(treeModel, &TreeModel::ItemRemoved, resourceMap, &ResourceModelMap::ResourceRemoved,
           Qt::DirectConnection);
   connect(pm, &ProtoModel::dataChanged, resourceMap, &ResourceModelMap::dataChanged,
@@ -459,6 +525,30 @@ void MainWindow::openProject(std::unique_ptr<buffers::Project> openedProject) {
 
 void MainWindow::on_actionNew_triggered() { openNewProject(); }
 
+void MainWindow::saveProject(const QString &fName) {
+  // Only resources edited since the last save are copied here; the rest of the project is put together on the
+  // saving thread. Edits made while it is being written mark the project modified again.
+  _saver->Save(_snapshots->Take(_project.get(), resourceModel), fName);
+  setWindowModified(false);
+}
+
+void MainWindow::on_actionSave_triggered() {
+  if (_projectFile.isEmpty()) return on_actionSaveAs_triggered();
+  if (isWindowModified()) saveProject(_projectFile);
+}
+
+void MainWindow::on_actionSaveAs_triggered() {
+  const QString &fileName =
+      QFileDialog::getSaveFileName(this, tr("Save Project"), _projectFile, tr("ENIGMA Projects (*.egm)"));
+  if (fileName.isEmpty()) return;
+  _projectFile = fileName;
+  MainWindow::setWindowTitle(QFileInfo(fileName).fileName() + "[*] - ENIGMA");
+  saveProject(fileName);
+}
+
+// Editors write through to the project as changes are made, so there is nothing else to gather first.
+void MainWindow::on_actionSaveAll_triggered() { on_actionSave_triggered(); }
+
 void MainWindow::on_actionOpen_triggered() {
   const QString &fileName = QFileDialog::getOpenFileName(
       this, tr("Open Project"), "",
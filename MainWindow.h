@@ -9,6 +9,10 @@
 class MainWindow;
 #include "Components/RecentFiles.h"
 
+class ProjectLoader;
+class ProjectSaver;
+class SnapshotCache;
+
 #include "project.pb.h"
 #include "server.pb.h"
 #include "event_reader/event_parser.h"
@@ -19,6 +23,7 @@ class MainWindow;
 #include <QMdiSubWindow>
 #include <QPointer>
 #include <QProcess>
+#include <QProgressDialog>
 #include <QFileInfo>
 
 namespace Ui {
@@ -60,6 +65,9 @@ class MainWindow : public QMainWindow {
   // file menu
   void on_actionNew_triggered();
   void on_actionOpen_triggered();
+  void on_actionSave_triggered();
+  void on_actionSaveAs_triggered();
+  void on_actionSaveAll_triggered();
   void on_actionClearRecentMenu_triggered();
   void on_actionPreferences_triggered();
   void on_actionExit_triggered();
@@ -108,6 +116,8 @@ class MainWindow : public QMainWindow {
   void on_treeView_doubleClicked(const QModelIndex &index);
   void on_treeView_customContextMenuRequested(const QPoint &pos);
 
+  void projectLoaded(const QString &fName);
+
  private:
   void closeEvent(QCloseEvent *event) override;
 
@@ -119,9 +129,17 @@ class MainWindow : public QMainWindow {
 
   std::unique_ptr<buffers::Project> _project;
   QPointer<RecentFiles> _recentFiles;
+  ProjectLoader *_loader;
+  QPointer<QProgressDialog> _loadProgress;
+  ProjectSaver *_saver;
+  // Resources as of the last save, so the next one only copies what was edited since.
+  SnapshotCache *_snapshots;
+  // Where Save writes to; empty until the project has a writable (EGM) location.
+  QString _projectFile;
 
   static std::unique_ptr<EventData> _event_data;
 
+  void saveProject(const QString &fName);
   void readSettings();
   void writeSettings();
   void setTabbedMode(bool enabled);
@@ -0,0 +1,391 @@
+#include "ChangeJournal.h"
+#include "Components/Logger.h"
+#include "MessageModel.h"
+#include "RepeatedMessageModel.h"
+
+#include <QTimer>
+
+#include <algorithm>
+
+namespace {
+
+int external_edit_depth = 0;
+
+// Past either limit the oldest steps are dropped, after snapshotting the base so Revert still works.
+constexpr int kMaxSteps = 1000;
+constexpr std::size_t kMaxBytes = 32 * 1024 * 1024;
+// Steps setting the same fields closer together than this are folded into one.
+constexpr qint64 kMergeIntervalMs = 500;
+
+std::size_t VariantBytes(const QVariant &value) {
+  switch (value.type()) {
+    case QVariant::String: return value.toString().size() * sizeof(QChar);
+    case QVariant::ByteArray: return value.toByteArray().size();
+    default: return 0;
+  }
+}
+
+}  // namespace
+
+ChangeJournal::ExternalEdit::ExternalEdit() { ++external_edit_depth; }
+
+ChangeJournal::ExternalEdit::~ExternalEdit() { --external_edit_depth; }
+
+ChangeJournal::ChangeJournal(MessageModel *root, QObject *parent) : QObject(parent), _root(root) {
+  if (root->journal_) qDebug() << "Replacing the change journal of" << root->DebugName();
+  root->journal_ = this;
+  _clock.start();
+}
+
+ChangeJournal::~ChangeJournal() {
+  if (_root && _root->journal_ == this) _root->journal_ = nullptr;
+  // Goes before the buffer it points into, rather than with the rest of our children.
+  delete _baseModel;
+}
+
+ChangeJournal *ChangeJournal::For(ProtoModel *model) {
+  for (ProtoModel *m = model; m; m = m->GetParentModel()) {
+    if (m->journal_) return m->journal_->_replaying ? nullptr : m->journal_;
+  }
+  return nullptr;
+}
+
+bool ChangeJournal::Address(ProtoModel *model, QVector<int> *address) const {
+  for (ProtoModel *m = model; m; m = m->GetParentModel()) {
+    if (m == _root) {
+      std::reverse(address->begin(), address->end());
+      return true;
+    }
+    address->append(m->RowInParent());
+  }
+  return false;
+}
+
+ProtoModel *ChangeJournal::Resolve(ProtoModel *root, const QVector<int> &address) {
+  ProtoModel *model = root;
+  for (int row : address) {
+    if (MessageModel *message = model->TryCastAsMessageModel()) {
+      model = message->SubModelForRow(row);
+    } else if (RepeatedModel *repeated = model->TryCastAsRepeatedModel()) {
+      model = repeated->GetSubModel(row);
+    } else {
+      model = nullptr;
+    }
+    if (!model) return nullptr;
+  }
+  return model;
+}
+
+ChangeJournal::Block ChangeJournal::CopyRows(RepeatedModel *model, int first, int last) {
+  Block block;
+  block.first = first;
+  RepeatedMessageModel *messages = model->TryCastAsRepeatedMessageModel();
+  for (int row = first; row <= last; ++row) {
+    if (messages) {
+      const Message &message = messages->MessageAt(row);
+      block.messages.emplace_back(message.New());
+      block.messages.back()->CopyFrom(message);
+    } else {
+      block.values.append(model->GetDirect(row));
+    }
+  }
+  return block;
+}
+
+std::size_t ChangeJournal::EntryBytes(const Entry &entry) {
+  std::size_t bytes = sizeof(Entry) + entry.address.size() * sizeof(int);
+  bytes += VariantBytes(entry.before) + VariantBytes(entry.after);
+  for (const Block &block : entry.blocks) {
+    for (const QVariant &value : block.values) bytes += sizeof(QVariant) + VariantBytes(value);
+    for (const auto &message : block.messages) bytes += message->SpaceUsedLong();
+  }
+  if (entry.buffer) bytes += entry.buffer->SpaceUsedLong();
+  if (entry.replacement) bytes += entry.replacement->SpaceUsedLong();
+  return bytes;
+}
+
+ChangeJournal::Entry *ChangeJournal::Append(Entry::Kind kind, ProtoModel *model) {
+  const bool external = external_edit_depth > 0;
+  if (external && kind != Entry::kSetData && kind != Entry::kSetRow) {
+    // Rows shifted underneath the history, so its addresses can't be trusted anymore. Keep the snapshot for Revert
+    // and start over.
+    BaseModel();
+    DropEntries(0, _entries.size());
+    emit HistoryChanged();
+    return nullptr;
+  }
+
+  QVector<int> address;
+  R_EXPECT(Address(model, &address), nullptr) << model->DebugName() << "is not part of the journaled model";
+  // Anything undone is gone for good once something new happens.
+  if (CanRedo()) DropEntries(_cursor, _entries.size());
+  _entries.emplace_back();
+  Entry &entry = _entries.back();
+  entry.kind = kind;
+  entry.address = std::move(address);
+  entry.external = external;
+  entry.time = _clock.elapsed();
+  if (!_stepOpen) {
+    entry.stepStart = true;
+    _stepOpen = true;
+    QTimer::singleShot(0, this, &ChangeJournal::CloseStep);
+  }
+  ++_cursor;
+  return &entry;
+}
+
+void ChangeJournal::RecordSetData(MessageModel *model, int row, int role, const QVariant &oldValue,
+                                  const QVariant &newValue) {
+  if (Entry *entry = Append(Entry::kSetData, model)) {
+    entry->row = row;
+    entry->role = role;
+    entry->before = oldValue;
+    entry->after = newValue;
+  }
+}
+
+void ChangeJournal::RecordSetRow(RepeatedModel *model, int row, const QVariant &oldValue, const QVariant &newValue) {
+  if (Entry *entry = Append(Entry::kSetRow, model)) {
+    entry->row = row;
+    entry->before = oldValue;
+    entry->after = newValue;
+  }
+}
+
+void ChangeJournal::RecordInsert(RepeatedModel *model, int row, int count) {
+  if (Entry *entry = Append(Entry::kInsert, model)) {
+    entry->row = row;
+    entry->count = count;
+  }
+}
+
+void ChangeJournal::RecordRemove(RepeatedModel *model, const std::vector<std::pair<int, int>> &ranges) {
+  Entry *entry = Append(Entry::kRemove, model);
+  if (!entry) return;
+  for (const auto &range : ranges) entry->blocks.push_back(CopyRows(model, range.first, range.second));
+}
+
+void ChangeJournal::RecordMove(RepeatedModel *model, int source, int count, int destination) {
+  if (Entry *entry = Append(Entry::kMove, model)) {
+    entry->row = source;
+    entry->count = count;
+    entry->destination = destination;
+  }
+}
+
+void ChangeJournal::RecordReplace(MessageModel *model) {
+  Entry *entry = Append(Entry::kReplace, model);
+  if (!entry) return;
+  entry->buffer.reset(model->GetBuffer()->New());
+  entry->buffer->CopyFrom(*model->GetBuffer());
+}
+
+void ChangeJournal::Apply(Entry &entry, ProtoModel *root, bool undo, bool capture) {
+  ProtoModel *model = Resolve(root, entry.address);
+  R_EXPECT_V(model) << "Journaled model no longer exists";
+  MessageModel *message = model->TryCastAsMessageModel();
+  RepeatedModel *repeated = model->TryCastAsRepeatedModel();
+  if (entry.kind == Entry::kSetData || entry.kind == Entry::kReplace) {
+    R_EXPECT_V(message) << "Expected a message model at the journaled address, got" << model->DebugName();
+  } else {
+    R_EXPECT_V(repeated) << "Expected a repeated model at the journaled address, got" << model->DebugName();
+  }
+
+  // Blocks are in ascending order, so each one goes back at its original row.
+  auto insertBlocks = [&]() {
+    for (const Block &block : entry.blocks) {
+      if (RepeatedMessageModel *messages = repeated->TryCastAsRepeatedMessageModel()) {
+        QVector<const Message *> rows;
+        rows.reserve(block.messages.size());
+        for (const auto &row : block.messages) rows.append(row.get());
+        messages->InsertRange(block.first, rows);
+      } else {
+        repeated->InsertRange(block.first, block.values);
+      }
+    }
+  };
+
+  switch (entry.kind) {
+    case Entry::kSetData:
+      message->setData(message->index(entry.row), undo ? entry.before : entry.after, entry.role);
+      break;
+    case Entry::kSetRow:
+      repeated->setData(repeated->index(entry.row, 0), undo ? entry.before : entry.after);
+      break;
+    case Entry::kInsert:
+      if (undo) {
+        if (capture) {
+          entry.blocks.clear();
+          entry.blocks.push_back(CopyRows(repeated, entry.row, entry.row + entry.count - 1));
+        }
+        RepeatedModel::RowRemovalOperation(repeated).RemoveRows(entry.row, entry.count);
+      } else {
+        insertBlocks();
+      }
+      break;
+    case Entry::kRemove:
+      if (undo) {
+        insertBlocks();
+      } else {
+        RepeatedModel::RowRemovalOperation remover(repeated);
+        for (const Block &block : entry.blocks) {
+          remover.RemoveRows(block.first, block.messages.size() + block.values.size());
+        }
+      }
+      break;
+    case Entry::kMove:
+      if (!undo) {
+        repeated->moveRows(entry.row, entry.count, entry.destination);
+      } else if (entry.destination < entry.row) {
+        repeated->moveRows(entry.destination, entry.count, entry.row + entry.count);
+      } else {
+        repeated->moveRows(entry.destination - entry.count, entry.count, entry.row);
+      }
+      break;
+    case Entry::kReplace:
+      if (undo) {
+        if (capture) {
+          entry.replacement.reset(message->GetBuffer()->New());
+          entry.replacement->CopyFrom(*message->GetBuffer());
+        }
+        message->ReplaceBuffer(entry.buffer.get());
+      } else if (entry.replacement) {
+        message->ReplaceBuffer(entry.replacement.get());
+      }
+      break;
+  }
+  if (capture) Account(entry);
+}
+
+void ChangeJournal::Account(Entry &entry) {
+  _bytes -= entry.bytes;
+  entry.bytes = EntryBytes(entry);
+  _bytes += entry.bytes;
+}
+
+void ChangeJournal::Undo() {
+  if (!CanUndo() || !_root) return;
+  _stepOpen = false;
+  _replaying = true;
+  {
+    ProtoModel::ChangeBatch batch;
+    do {
+      Entry &entry = _entries[--_cursor];
+      if (!entry.external) Apply(entry, _root, true, true);
+    } while (_cursor > 0 && !_entries[_cursor].stepStart);
+  }
+  _replaying = false;
+  emit HistoryChanged();
+}
+
+void ChangeJournal::Redo() {
+  if (!CanRedo() || !_root) return;
+  _replaying = true;
+  {
+    ProtoModel::ChangeBatch batch;
+    do {
+      Entry &entry = _entries[_cursor++];
+      if (!entry.external) Apply(entry, _root, false, true);
+    } while (CanRedo() && !_entries[_cursor].stepStart);
+  }
+  _replaying = false;
+  emit HistoryChanged();
+}
+
+void ChangeJournal::CloseStep() {
+  if (!_stepOpen) return;
+  _stepOpen = false;
+  std::size_t first = _entries.size();
+  while (first > 0) {
+    if (_entries[--first].stepStart) break;
+  }
+  for (std::size_t i = first; i < _entries.size(); ++i) Account(_entries[i]);
+  MergeStep();
+  Trim();
+  emit HistoryChanged();
+}
+
+void ChangeJournal::MergeStep() {
+  if (CanRedo() || _entries.empty()) return;
+  std::size_t current = _entries.size() - 1;
+  while (current > 0 && !_entries[current].stepStart) --current;
+  if (current == 0) return;
+  std::size_t previous = current - 1;
+  while (previous > 0 && !_entries[previous].stepStart) --previous;
+
+  const std::size_t count = _entries.size() - current;
+  if (current - previous != count) return;
+  if (_entries[current].time - _entries[current - 1].time > kMergeIntervalMs) return;
+  for (std::size_t i = 0; i < count; ++i) {
+    const Entry &older = _entries[previous + i], &newer = _entries[current + i];
+    const bool set = newer.kind == Entry::kSetData || newer.kind == Entry::kSetRow;
+    if (!set || newer.external || older.external || newer.kind != older.kind || newer.address != older.address ||
+        newer.row != older.row || newer.role != older.role) {
+      return;
+    }
+  }
+
+  for (std::size_t i = 0; i < count; ++i) {
+    Entry &older = _entries[previous + i];
+    older.after = _entries[current + i].after;
+    older.time = _entries[current + i].time;
+    Account(older);
+  }
+  DropEntries(current, _entries.size());
+}
+
+void ChangeJournal::Trim() {
+  int steps = std::count_if(_entries.begin(), _entries.end(), [](const Entry &entry) { return entry.stepStart; });
+  while (steps > kMaxSteps || _bytes > kMaxBytes) {
+    std::size_t end = 1;
+    while (end < _entries.size() && !_entries[end].stepStart) ++end;
+    // Always keep the latest step, however large.
+    if (end >= _entries.size() || end > _cursor) return;
+    if (!BaseModel()) return;
+    DropEntries(0, end);
+    --steps;
+  }
+}
+
+void ChangeJournal::DropEntries(std::size_t first, std::size_t last) {
+  if (first >= last) return;
+  for (std::size_t i = first; i < last; ++i) _bytes -= _entries[i].bytes;
+  // An open step loses its first entry, so whatever comes next has to start a new one.
+  if (last == _entries.size()) _stepOpen = false;
+  _entries.erase(_entries.begin() + first, _entries.begin() + last);
+  if (_cursor >= last) {
+    _cursor -= last - first;
+  } else if (_cursor > first) {
+    _cursor = first;
+  }
+}
+
+bool ChangeJournal::Revert() {
+  R_EXPECT(_root, false) << "Reverting the journal of a model which no longer exists";
+  _replaying = true;
+  if (_baseModel) {
+    _root->ReplaceBuffer(_baseModel->GetBuffer());
+  } else {
+    ProtoModel::ChangeBatch batch;
+    while (_cursor > 0) {
+      Entry &entry = _entries[--_cursor];
+      if (!entry.external) Apply(entry, _root, true, false);
+    }
+  }
+  DropEntries(0, _entries.size());
+  _replaying = false;
+  emit HistoryChanged();
+  return true;
+}
+
+MessageModel *ChangeJournal::BaseModel() {
+  if (_baseModel || !_root) return _baseModel;
+  _baseBuffer.reset(_root->GetBuffer()->New());
+  _baseBuffer->CopyFrom(*_root->GetBuffer());
+  _baseModel = new MessageModel(ProtoModel::NonProtoParent{this}, _baseBuffer.get());
+  _baseModel->RebuildSubModels();
+  for (std::size_t i = _cursor; i > 0; --i) {
+    if (!_entries[i - 1].external) Apply(_entries[i - 1], _baseModel, true, false);
+  }
+  return _baseModel;
+}
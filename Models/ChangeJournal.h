@@ -0,0 +1,134 @@
+#ifndef CHANGEJOURNAL_H
+#define CHANGEJOURNAL_H
+
+#include "ProtoModel.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QVariant>
+#include <QVector>
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Records every edit made to a model (usually the resource behind an open editor) and everything beneath it, as the
+// inverse of what changed. Starting a journal costs nothing; undoing or reverting replays only the edits that were
+// made, in place, so views see the same row and data notifications as they would for a normal edit.
+//
+// Edits are addressed by the rows leading from the journal's root down to the model that changed, so replaying them
+// backwards over a model of the same shape reproduces the root's starting state, whether that is the root itself
+// or a copy of it (see BaseModel).
+//
+// Edits made in the same pass of the event loop form one undo step. A step which only sets the same fields as the
+// step before it (e.g. each mouse move while dragging an instance) is folded into that step.
+class ChangeJournal : public QObject {
+  Q_OBJECT
+
+ public:
+  ChangeJournal(MessageModel *root, QObject *parent);
+  ~ChangeJournal() override;
+
+  // The journal covering the given model, or null if none does (or it is busy replaying its own edits).
+  static ChangeJournal *For(ProtoModel *model);
+
+  // Edits made while one of these exists come from outside the editor (e.g. references patched after a rename).
+  // Undo and Revert leave them in place rather than undoing them. Rows added or removed this way can't be stepped
+  // over, so they clear the undo history instead.
+  class ExternalEdit {
+   public:
+    ExternalEdit();
+    ~ExternalEdit();
+    ExternalEdit(const ExternalEdit &) = delete;
+    ExternalEdit &operator=(const ExternalEdit &) = delete;
+  };
+
+  // Hooks called by the models. Row removals and buffer replacements are recorded before they happen; everything
+  // else after.
+  void RecordSetData(MessageModel *model, int row, int role, const QVariant &oldValue, const QVariant &newValue);
+  void RecordSetRow(RepeatedModel *model, int row, const QVariant &oldValue, const QVariant &newValue);
+  void RecordInsert(RepeatedModel *model, int row, int count);
+  void RecordRemove(RepeatedModel *model, const std::vector<std::pair<int, int>> &ranges);
+  void RecordMove(RepeatedModel *model, int source, int count, int destination);
+  void RecordReplace(MessageModel *model);
+
+  bool CanUndo() const { return _cursor > 0; }
+  bool CanRedo() const { return _cursor < _entries.size(); }
+
+  // Puts the root back the way it was when the journal started.
+  bool Revert();
+
+  // A detached model holding the root as it was when the journal started. It is only built on request, by replaying
+  // the journal backwards over a copy of the root. From then on Revert restores the root from this model instead.
+  // Meant for edits which have to be made to both sides (e.g. deleting a resource's instances from a room); those
+  // can't be expressed as a replay. Also built to drop the oldest steps once the history grows too large.
+  MessageModel *BaseModel();
+
+  int Size() const { return _entries.size(); }
+
+ public slots:
+  void Undo();
+  void Redo();
+
+ signals:
+  // Emitted whenever CanUndo or CanRedo may have changed.
+  void HistoryChanged();
+
+ private:
+  struct Block {
+    int first = 0;
+    QVariantList values;                             // Rows of a scalar field.
+    std::vector<std::unique_ptr<Message>> messages;  // Rows of a message field.
+  };
+
+  struct Entry {
+    enum Kind { kSetData, kSetRow, kInsert, kRemove, kMove, kReplace } kind;
+    // Rows from the root down to the model that changed.
+    QVector<int> address;
+    int row = 0;
+    int count = 0;
+    int destination = 0;
+    int role = Qt::EditRole;
+    QVariant before;
+    QVariant after;
+    // Removed rows, one block per contiguous range. Inserted rows are kept here too once undone, for redo.
+    std::vector<Block> blocks;
+    // The buffer as it was before a replacement, and as it was after once the replacement is undone.
+    std::unique_ptr<Message> buffer;
+    std::unique_ptr<Message> replacement;
+    bool external = false;
+    // First entry of an undo step.
+    bool stepStart = false;
+    qint64 time = 0;
+    std::size_t bytes = 0;
+  };
+
+  bool Address(ProtoModel *model, QVector<int> *address) const;
+  static ProtoModel *Resolve(ProtoModel *root, const QVector<int> &address);
+  static Block CopyRows(RepeatedModel *model, int first, int last);
+  static std::size_t EntryBytes(const Entry &entry);
+  Entry *Append(Entry::Kind kind, ProtoModel *model);
+  // Applies the entry (or its inverse) to the model tree below `root`. With `capture`, whatever the entry needs to
+  // be applied the other way again is saved into it.
+  void Apply(Entry &entry, ProtoModel *root, bool undo, bool capture);
+  void Account(Entry &entry);
+  void CloseStep();
+  void MergeStep();
+  void Trim();
+  void DropEntries(std::size_t first, std::size_t last);
+
+  QPointer<MessageModel> _root;
+  std::vector<Entry> _entries;
+  // Entries before the cursor are applied; the ones after it have been undone and can be redone.
+  std::size_t _cursor = 0;
+  std::size_t _bytes = 0;
+  bool _stepOpen = false;
+  QElapsedTimer _clock;
+  std::unique_ptr<Message> _baseBuffer;
+  MessageModel *_baseModel = nullptr;
+  bool _replaying = false;
+};
+
+#endif  // CHANGEJOURNAL_H
@@ -1,10 +1,13 @@
 #include "MessageModel.h"
+#include "ChangeJournal.h"
 #include "Components/ArtManager.h"
 #include "Components/Logger.h"
 #include "RepeatedMessageModel.h"
 #include "RepeatedPrimitiveModel.h"
 #include "ResourceModelMap.h"
 
+#include <unordered_set>
+
 static constexpr int CCP_TYPE_ROLE = Qt::UserRole + 1;
 
 MessageModel::MessageModel(ProtoModel *parent, Message *protobuf, int row_in_parent)
@@ -70,75 +73,77 @@ bool MessageModel::IsCulledOneofRow(int row) const {
   return IsCulledOneof_(_protobuf->GetReflection(), *_protobuf, descriptor_->field(row));
 }
 
+static bool ReachesResourceRef(const Descriptor *desc, std::unordered_set<const Descriptor *> &visited) {
+  if (!visited.insert(desc).second) return false;
+  for (int i = 0; i < desc->field_count(); i++) {
+    const FieldDescriptor *field = desc->field(i);
+    if (!field->options().GetExtension(buffers::resource_ref).empty()) return true;
+    if (field->cpp_type() == CppType::CPPTYPE_MESSAGE && ReachesResourceRef(field->message_type(), visited))
+      return true;
+  }
+  return false;
+}
+
+bool MessageModel::HasResourceRefs(const FieldDescriptor *field) {
+  if (!field->options().GetExtension(buffers::resource_ref).empty()) return true;
+  if (field->cpp_type() != CppType::CPPTYPE_MESSAGE) return false;
+  // Only whole walks are cached; a partial result from inside a recursive type would be wrong.
+  static QHash<const Descriptor *, bool> cache;
+  auto it = cache.find(field->message_type());
+  if (it != cache.end()) return *it;
+  std::unordered_set<const Descriptor *> visited;
+  return cache[field->message_type()] = ReachesResourceRef(field->message_type(), visited);
+}
+
 void MessageModel::RebuildSubModels() {
   submodels_by_field_.clear();
   submodels_by_row_.clear();
   R_EXPECT_V(_protobuf) << "Internal protobuf null";
 
   const Descriptor *desc = _protobuf->GetDescriptor();
-  const Reflection *refl = _protobuf->GetReflection();
-  submodels_by_row_.resize(desc->field_count());
+  submodels_by_row_.fill(nullptr, desc->field_count());
+}
 
-  for (int i = 0; i < desc->field_count(); i++) {
-    const FieldDescriptor *field = desc->field(i);
+ProtoModel *MessageModel::BuildSubModel(int row) const {
+  R_EXPECT(_protobuf, nullptr) << "Internal protobuf null";
+  R_EXPECT(row >= 0 && row < submodels_by_row_.size(), nullptr) << "Building submodel for bad row" << row;
 
-    if (field->is_repeated()) {
-      switch (field->cpp_type()) {
-        case CppType::CPPTYPE_ENUM: {
-          qDebug() << "ENUMs not yet handled";
-          break;
-        }
-        case CppType::CPPTYPE_MESSAGE: {
-          submodels_by_field_[field->number()] = submodels_by_row_[i] = new RepeatedMessageModel(this, _protobuf, field);
-          break;
-        }
-        case CppType::CPPTYPE_BOOL: {
-          submodels_by_field_[field->number()] = submodels_by_row_[i] = new RepeatedBoolModel(this, _protobuf, field);
-          break;
-        }
-        case CppType::CPPTYPE_INT32: {
-          submodels_by_field_[field->number()] = submodels_by_row_[i] = new RepeatedInt32Model(this, _protobuf, field);
-          break;
-        }
-        case CppType::CPPTYPE_INT64: {
-          submodels_by_field_[field->number()] = submodels_by_row_[i] = new RepeatedInt64Model(this, _protobuf, field);
-          break;
-        }
-        case CppType::CPPTYPE_UINT32: {
-          submodels_by_field_[field->number()] = submodels_by_row_[i] = new RepeatedUInt32Model(this, _protobuf, field);
-          break;
-        }
-        case CppType::CPPTYPE_UINT64: {
-          submodels_by_field_[field->number()] = submodels_by_row_[i] = new RepeatedUInt64Model(this, _protobuf, field);
-          break;
-        }
-        case CppType::CPPTYPE_FLOAT: {
-          submodels_by_field_[field->number()] = submodels_by_row_[i] = new RepeatedFloatModel(this, _protobuf, field);
-          break;
-        }
-        case CppType::CPPTYPE_DOUBLE: {
-          submodels_by_field_[field->number()] = submodels_by_row_[i] = new RepeatedDoubleModel(this, _protobuf, field);
-          break;
-        }
-        case CppType::CPPTYPE_STRING: {
-          submodels_by_field_[field->number()] = submodels_by_row_[i] = new RepeatedStringModel(this, _protobuf, field);
-          break;
-        }
-      }
-    } else if (field->cpp_type() == CppType::CPPTYPE_MESSAGE) {
-      // Ignore all unset oneof fields if any is set
-      if (IsCulledOneof_(refl, *_protobuf, field)) continue;
-      // Only recursively build fields if they're set
-      if (refl->HasField(*_protobuf, field)) {
-        submodels_by_field_[field->number()] = submodels_by_row_[i] =
-            new MessageModel(this, refl->MutableMessage(_protobuf, field), i);
-      } else {
-        submodels_by_field_[field->number()] = submodels_by_row_[i] = new MessageModel(this, field->message_type(), i);
+  MessageModel *self = const_cast<MessageModel *>(this);
+  const Reflection *refl = _protobuf->GetReflection();
+  const FieldDescriptor *field = descriptor_->field(row);
+  ProtoModel *model = nullptr;
+
+  if (field->is_repeated()) {
+    switch (field->cpp_type()) {
+      case CppType::CPPTYPE_ENUM: {
+        qDebug() << "ENUMs not yet handled";
+        break;
       }
+      case CppType::CPPTYPE_MESSAGE: model = new RepeatedMessageModel(self, _protobuf, field); break;
+      case CppType::CPPTYPE_BOOL: model = new RepeatedBoolModel(self, _protobuf, field); break;
+      case CppType::CPPTYPE_INT32: model = new RepeatedInt32Model(self, _protobuf, field); break;
+      case CppType::CPPTYPE_INT64: model = new RepeatedInt64Model(self, _protobuf, field); break;
+      case CppType::CPPTYPE_UINT32: model = new RepeatedUInt32Model(self, _protobuf, field); break;
+      case CppType::CPPTYPE_UINT64: model = new RepeatedUInt64Model(self, _protobuf, field); break;
+      case CppType::CPPTYPE_FLOAT: model = new RepeatedFloatModel(self, _protobuf, field); break;
+      case CppType::CPPTYPE_DOUBLE: model = new RepeatedDoubleModel(self, _protobuf, field); break;
+      case CppType::CPPTYPE_STRING: model = new RepeatedStringModel(self, _protobuf, field); break;
+    }
+  } else if (field->cpp_type() == CppType::CPPTYPE_MESSAGE) {
+    // Ignore all unset oneof fields if any is set
+    if (IsCulledOneof_(refl, *_protobuf, field)) return nullptr;
+    // Only recursively build fields if they're set
+    if (refl->HasField(*_protobuf, field)) {
+      model = new MessageModel(self, refl->MutableMessage(_protobuf, field), row);
     } else {
-      submodels_by_field_[field->number()] = submodels_by_row_[i] = new PrimitiveModel(this, field);
+      model = new MessageModel(self, field->message_type(), row);
     }
+  } else {
+    model = new PrimitiveModel(self, field);
   }
+
+  if (model) submodels_by_field_[field->number()] = submodels_by_row_[row] = model;
+  return model;
 }
 
 int MessageModel::rowCount(const QModelIndex &parent) const {
@@ -158,6 +163,9 @@ bool MessageModel::setData(const QModelIndex &index, const QVariant &value, int
   if (!field) return false;
 
   const QVariant oldValue = this->data(index, role);
+  ChangeJournal *journal = field->cpp_type() != CppType::CPPTYPE_MESSAGE ? ChangeJournal::For(this) : nullptr;
+  // Journals keep the effective value, so that a field which was unset reverts to its default.
+  const QVariant journaledValue = journal ? dataInternal<false>(index, role) : QVariant();
 
   switch (field->cpp_type()) {
     case CppType::CPPTYPE_MESSAGE: {
@@ -185,9 +193,18 @@ bool MessageModel::setData(const QModelIndex &index, const QVariant &value, int
   }
 
   SetDirty(true);
+  if (journal) journal->RecordSetData(this, index.row(), role, journaledValue, value);
   emit DataChanged(index, index, oldValue);
   ParentDataChanged();
 
+  if (!field->options().GetExtension(buffers::resource_ref).empty()) {
+    ProtoModel *submodel = SubModelForRow(index.row());
+    if (PrimitiveModel *reference = submodel ? submodel->TryCastAsPrimitiveModel() : nullptr) {
+      const QString old_name = oldValue.toString();
+      for (ProtoModel *m = this; m; m = m->GetParentModel()) emit m->ResourceReferenceChanged(reference, old_name);
+    }
+  }
+
   return true;
 }
 
@@ -197,9 +214,9 @@ const ProtoModel *MessageModel::GetSubModel(const FieldPath &field_path) const {
     return nullptr;
   }
   if (!field_path) return this;
-  auto smit = submodels_by_field_.find(field_path.front()->number());
-  if (smit == submodels_by_field_.end()) return nullptr;
-  return smit.value()->GetSubModel(field_path.SkipField());
+  const ProtoModel *submodel = GetSubModel<ProtoModel>(field_path.front()->number());
+  if (!submodel) return nullptr;
+  return submodel->GetSubModel(field_path.SkipField());
 }
 
 QVariant MessageModel::Data() const {
@@ -255,7 +272,8 @@ QVariant MessageModel::dataInternal(const QModelIndex &index, int role) const {
 
   // These are for icons in things like the room's instance list
   if (role == Qt::DecorationRole) {
-    return submodels_by_row_[index.row()]->GetDisplayIcon();
+    const ProtoModel *submodel = SubModelForRow(index.row());
+    return submodel ? submodel->GetDisplayIcon() : QIcon();
   }
 
   // The logic below will kill proto if the field is repeated. Abort now.
@@ -318,30 +336,25 @@ Qt::ItemFlags MessageModel::flags(const QModelIndex &index) const {
   return flags;
 }
 
-MessageModel *MessageModel::BackupModel(QObject *parent) {
+ChangeJournal *MessageModel::StartJournal(QObject *parent) {
   if (!_protobuf) return nullptr;
-  _backupProtobuf.reset(_protobuf->New());
-  _backupProtobuf->CopyFrom(*_protobuf);
-  _modelBackup = new MessageModel(NonProtoParent{parent}, _backupProtobuf.get());
-  _modelBackup->RebuildSubModels();
-  return _modelBackup;
+  return new ChangeJournal(this, parent);
 }
 
-MessageModel *MessageModel::GetBackupModel() { return _modelBackup; }
-
 void MessageModel::ReplaceBuffer(const Message *buffer) {
+  if (ChangeJournal *journal = ChangeJournal::For(this)) journal->RecordReplace(this);
   beginResetModel();
   SetDirty(true);
   _protobuf->CopyFrom(*buffer);
   qDebug() << "Buffer replaced; rebuilding submodels";
   RebuildSubModels();
   endResetModel();
+  for (ProtoModel *m = this; m; m = m->GetParentModel()) emit m->ResourceReferencesAdded(this, _protobuf);
 }
 
 bool MessageModel::RestoreBackup() {
-  if (_modelBackup == nullptr) return false;
-  ReplaceBuffer(_modelBackup->GetBuffer());
-  return true;
+  if (journal_ == nullptr) return false;
+  return journal_->Revert();
 }
 
 Message *MessageModel::GetBuffer() { return _protobuf; }
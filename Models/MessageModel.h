@@ -6,6 +6,7 @@
 #include "Components/Logger.h"
 
 #include <QHash>
+#include <QSet>
 
 // Model representing a protobuf message
 class MessageModel : public ProtoModel {
@@ -20,20 +21,27 @@ class MessageModel : public ProtoModel {
   MessageModel(NonProtoParent parent, Message *protobuf);
 
   // On either intialization or restore of a model all
-  // refrences to to the submodels it owns recursively must be updated
+  // refrences to to the submodels it owns recursively must be updated.
+  // Submodels are built lazily on first access.
   void RebuildSubModels();
 
+  // Returns true if the given field is, or transitively contains, a field tagged with a resource_ref.
+  static bool HasResourceRefs(const FieldDescriptor *field);
+
   // All editor changes are made instantly rather than on confirm.
-  // Whenever an editor is spawned a copy of the underlying protobuf is made.
-  // In the event the user opts to close the editor and undo their changes this backup is restored.
-  MessageModel *GetBackupModel();
-  MessageModel *BackupModel(QObject *parent);
+  // Whenever an editor is spawned a journal of the edits made beneath this model is started (see ChangeJournal).
+  // In the event the user opts to close the editor and undo their changes those edits are reverted.
+  ChangeJournal *GetJournal() const { return journal_; }
+  ChangeJournal *StartJournal(QObject *parent);
   bool RestoreBackup();
 
   template<typename T, EnableIfCastable<T> = true>
   auto* GetSubModel(int fieldNum) const {
     auto it = submodels_by_field_.find(fieldNum);
-    return it == submodels_by_field_.end() ? nullptr : (*it)->As<T>();
+    if (it != submodels_by_field_.end()) return (*it)->As<T>();
+    const FieldDescriptor *field = descriptor_->FindFieldByNumber(fieldNum);
+    ProtoModel *model = (field && _protobuf) ? BuildSubModel(field->index()) : nullptr;
+    return model ? model->As<T>() : nullptr;
   }
 
   QString GetDisplayName() const override;
@@ -71,9 +79,17 @@ class MessageModel : public ProtoModel {
                << " (" << submodels_by_row_.size() << " rows)";
       return nullptr;
     }
+    if (!submodels_by_row_[row]) return BuildSubModel(row);
     return submodels_by_row_[row];
   }
 
+  // Typed, read-only access to the underlying buffer for render loops; skips submodels and QVariant entirely.
+  // Returns null if this model has no buffer or holds a different message type.
+  template<typename T> const T *ReadView() const {
+    if (!_protobuf || _protobuf->GetDescriptor() != T::descriptor()) return nullptr;
+    return static_cast<const T *>(_protobuf);
+  }
+
   // These are the same as the above but operate on the raw protobuf
   Message *GetBuffer();
   void ReplaceBuffer(const Message *buffer);
@@ -101,10 +117,13 @@ class MessageModel : public ProtoModel {
 
  protected:
   google::protobuf::Message *_protobuf;
-  MessageModel *_modelBackup = nullptr;
-  QScopedPointer<Message> _backupProtobuf;
-  QVector<ProtoModel *> submodels_by_row_;
-  QHash<int, ProtoModel *> submodels_by_field_;
+  // Caches of the submodels built so far; rows which have not been touched yet are null.
+  mutable QVector<ProtoModel *> submodels_by_row_;
+  mutable QHash<int, ProtoModel *> submodels_by_field_;
+
+ private:
+  // Constructs the submodel for the given row and caches it. Returns null for culled oneof rows.
+  ProtoModel *BuildSubModel(int row) const;
 };
 
 #endif
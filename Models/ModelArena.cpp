@@ -0,0 +1,117 @@
+#include "ModelArena.h"
+
+#include "Components/Logger.h"
+
+#include <QDebug>
+
+ModelArena *ModelArena::current_ = nullptr;
+quint32 ModelArena::last_id_ = 0;
+
+namespace {
+
+// Prefixed to every allocation so that Free() can find its way home without a lookup.
+struct alignas(std::max_align_t) ChunkHeader {
+  ModelArena *arena;
+  std::size_t chunk_size;
+};
+
+constexpr std::size_t kAlignment = alignof(std::max_align_t);
+constexpr std::size_t kBlockSize = 256 * 1024;
+
+constexpr std::size_t RoundUp(std::size_t size) { return (size + kAlignment - 1) & ~(kAlignment - 1); }
+
+}  // namespace
+
+ModelArena *ModelArena::Current() {
+  if (!current_) current_ = new ModelArena();
+  return current_;
+}
+
+void ModelArena::Reset() {
+  ModelArena *old = current_;
+  current_ = new ModelArena();
+  if (!old) return;
+  old->retired_ = true;
+  // Bump the count so an arena with nothing left in it is released by the same path as any other.
+  old->Retain();
+  old->Release();
+}
+
+void *ModelArena::Allocate(std::size_t size) {
+  ModelArena *arena = Current();
+  const std::size_t chunk_size = RoundUp(sizeof(ChunkHeader) + size);
+  auto *header = static_cast<ChunkHeader *>(arena->AllocateChunk(chunk_size));
+  header->arena = arena;
+  header->chunk_size = chunk_size;
+  arena->Retain();
+  return header + 1;
+}
+
+void ModelArena::Free(void *ptr) {
+  if (!ptr) return;
+  ChunkHeader *header = static_cast<ChunkHeader *>(ptr) - 1;
+  ModelArena *arena = header->arena;
+  arena->FreeChunk(header, header->chunk_size);
+  arena->Release();
+}
+
+void *ModelArena::AllocateChunk(std::size_t chunk_size) {
+  auto it = free_lists_.find(chunk_size);
+  if (it != free_lists_.end() && it->second) {
+    void *chunk = it->second;
+    it->second = *static_cast<void **>(chunk);
+    return chunk;
+  }
+
+  if (chunk_size > kBlockSize / 4) {
+    // Oversized objects get a block to themselves rather than wasting the tail of a shared one.
+    blocks_.emplace_back(new std::max_align_t[(chunk_size + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t)]);
+    reserved_ += chunk_size;
+    return blocks_.back().get();
+  }
+
+  if (std::size_t(limit_ - cursor_) < chunk_size) {
+    blocks_.emplace_back(new std::max_align_t[kBlockSize / sizeof(std::max_align_t)]);
+    cursor_ = reinterpret_cast<char *>(blocks_.back().get());
+    limit_ = cursor_ + kBlockSize;
+    reserved_ += kBlockSize;
+  }
+  void *chunk = cursor_;
+  cursor_ += chunk_size;
+  return chunk;
+}
+
+void ModelArena::FreeChunk(void *chunk, std::size_t chunk_size) {
+  void *&head = free_lists_[chunk_size];
+  *static_cast<void **>(chunk) = head;
+  head = chunk;
+}
+
+void ModelArena::Release() {
+  R_EXPECT_V(live_ > 0) << "Model arena released more objects than it allocated";
+  if (--live_ == 0 && retired_) delete this;
+}
+
+ModelHandle ModelArena::Register(const ProtoModel *model) {
+  quint32 index;
+  if (!free_slots_.empty()) {
+    index = free_slots_.back();
+    free_slots_.pop_back();
+  } else {
+    index = slots_.size();
+    slots_.emplace_back();
+  }
+  slots_[index].model = model;
+  Retain();
+  return {index, slots_[index].generation, id_};
+}
+
+bool ModelArena::Unregister(ModelHandle handle) {
+  if (!Lookup(handle)) return false;
+  Slot &slot = slots_[handle.index];
+  slot.model = nullptr;
+  ++slot.generation;
+  free_slots_.push_back(handle.index);
+  Release();
+  return true;
+}
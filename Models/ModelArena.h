@@ -0,0 +1,92 @@
+#ifndef MODELARENA_H
+#define MODELARENA_H
+
+#include <QtGlobal>
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class ProtoModel;
+
+// Generation-tagged reference to a live model. A handle stays cheap to validate after its model is gone:
+// the slot it points to either holds a newer generation or nothing at all. Handles also name the arena which issued
+// them, since every arena numbers its slots and generations from zero.
+struct ModelHandle {
+  quint32 index = ~0u;
+  quint32 generation = 0;
+  quint32 arena = 0;
+
+  bool operator==(const ModelHandle &other) const {
+    return index == other.index && generation == other.generation && arena == other.arena;
+  }
+  bool operator!=(const ModelHandle &other) const { return !(*this == other); }
+};
+
+// Pool which owns the storage of every model (and tree node) belonging to one open project.
+// ProtoModel and TreeModel::Node route their operator new/delete here, so a project's whole object graph lives in a
+// handful of large blocks instead of being scattered across the heap. When a project is closed the arena is retired;
+// it releases all of its blocks at once as soon as the last object allocated from it has been deleted.
+//
+// Not thread safe; models are only ever created and destroyed on the GUI thread.
+class ModelArena {
+ public:
+  // The arena new allocations are served from. Never null.
+  static ModelArena *Current();
+  // Retires the current arena and starts a fresh one for the next project.
+  static void Reset();
+
+  static void *Allocate(std::size_t size);
+  static void Free(void *ptr);
+
+  // Handle table used for O(1) liveness checks on models (replaces a global set of live pointers).
+  ModelHandle Register(const ProtoModel *model);
+  // Returns false if the handle was not live (i.e., a double-free).
+  bool Unregister(ModelHandle handle);
+  // Returns the model referred to by the given handle, or null if it has since been destroyed or came from another
+  // arena.
+  const ProtoModel *Lookup(ModelHandle handle) const {
+    if (handle.arena != id_ || handle.index >= slots_.size()) return nullptr;
+    const Slot &slot = slots_[handle.index];
+    return slot.generation == handle.generation ? slot.model : nullptr;
+  }
+
+  std::size_t LiveObjects() const { return live_; }
+  std::size_t ReservedBytes() const { return reserved_; }
+
+ private:
+  ModelArena() : id_(++last_id_) {}
+  ~ModelArena() = default;
+
+  void *AllocateChunk(std::size_t chunk_size);
+  void FreeChunk(void *chunk, std::size_t chunk_size);
+  void Retain() { ++live_; }
+  void Release();
+
+  struct Slot {
+    const ProtoModel *model = nullptr;
+    quint32 generation = 0;
+  };
+
+  std::vector<std::unique_ptr<std::max_align_t[]>> blocks_;
+  char *cursor_ = nullptr;
+  char *limit_ = nullptr;
+  std::size_t reserved_ = 0;
+  // Recycled chunks, keyed by chunk size. Each free chunk stores the next one in its first word.
+  std::unordered_map<std::size_t, void *> free_lists_;
+
+  std::vector<Slot> slots_;
+  std::vector<quint32> free_slots_;
+
+  // Distinguishes this arena's handles from those of earlier ones. Never zero, so default handles match none.
+  const quint32 id_;
+  // Allocations plus registered handles still outstanding.
+  std::size_t live_ = 0;
+  bool retired_ = false;
+
+  static ModelArena *current_;
+  static quint32 last_id_;
+};
+
+#endif  // MODELARENA_H
@@ -6,9 +6,32 @@
 
 #include <Components/ArtManager.h>
 #include <QIcon>
+#include <QTimer>
+
+#include <vector>
 
 ProtoModel::DisplayConfig ProtoModel::display_config_;
 
+namespace {
+
+struct PendingChange {
+  ProtoModel *model;
+  int first_row;
+  int last_row;
+};
+
+// Models with queued notifications, in the order they were first queued. All of this lives on the GUI thread.
+std::vector<PendingChange> pending_changes;
+QHash<ProtoModel *, size_t> pending_change_index;
+ProtoModel::NotificationStats notification_stats;
+// Changes currently being emitted by FlushChanges(), so that models destroyed mid-flush can be dropped. A slot may
+// flush again (e.g. by closing a ChangeBatch) while an outer flush is still emitting, so there is one per level.
+std::vector<std::vector<PendingChange> *> flushing_changes;
+int change_batch_depth = 0;
+bool flush_scheduled = false;
+
+}  // namespace
+
 ProtoModel::ProtoModel(NonProtoParent parent, std::string name, const Descriptor *descriptor)
   : ProtoModel(static_cast<ProtoModel *>(nullptr), name, descriptor, -1) {
   QObject::setParent(parent.parent);
@@ -21,8 +44,8 @@ ProtoModel::ProtoModel(ProtoModel *parent, std::string name, const Descriptor *d
       row_in_parent_(row_in_parent),
       debug_path_((parent ? parent->debug_path_ + "." : "") + QString::fromStdString(name)),
       descriptor_(descriptor),
-      live_pointers_(parent ? parent->live_pointers_ : std::make_shared<std::set<const ProtoModel*>>()) {
-  live_pointers_->insert(this);
+      arena_(parent ? parent->arena_ : ModelArena::Current()),
+      handle_(arena_->Register(this)) {
   connect(this, &ProtoModel::DataChanged, this,
           [this](const QModelIndex &topLeft, const QModelIndex &bottomRight,
                  const QVariant & /*oldValue*/ = QVariant(0), const QVector<int> &roles = QVector<int>()) {
@@ -30,31 +53,97 @@ ProtoModel::ProtoModel(ProtoModel *parent, std::string name, const Descriptor *d
           });
   if (parent) {
     connect(this, &ProtoModel::dataChanged, this, [this](const QModelIndex&, const QModelIndex&, const QVector<int>&) {
-      auto me = _parentModel->index(row_in_parent_);
-      emit _parentModel->dataChanged(me, me, {});
+      _parentModel->QueueChange(row_in_parent_, row_in_parent_);
     });
     connect(this, &ProtoModel::modelReset, this, [this]() {
-      auto me = _parentModel->index(row_in_parent_);
-      emit _parentModel->dataChanged(me, me, {});
+      _parentModel->QueueChange(row_in_parent_, row_in_parent_);
     });
   }
 }
 
 ProtoModel::~ProtoModel() {
-  if (auto me = live_pointers_->find(this); me == live_pointers_->end()) qDebug() << "CRITICAL: Double-free!";
-  else live_pointers_->erase(me);
+  if (auto it = pending_change_index.find(this); it != pending_change_index.end()) {
+    pending_changes[*it].model = nullptr;
+    pending_change_index.erase(it);
+  }
+  for (std::vector<PendingChange> *changes : flushing_changes) {
+    for (PendingChange &change : *changes) {
+      if (change.model == this) change.model = nullptr;
+    }
+  }
+  if (!arena_->Unregister(handle_)) qDebug() << "CRITICAL: Double-free!";
 }
 
 void ProtoModel::ParentDataChanged() {
-  ProtoModel *m = GetParentModel<ProtoModel *>();
-  while (m != nullptr) {
-    emit m->DataChanged(m->index(0, 0), m->index(rowCount() - 1, columnCount() - 1));
-    m = m->GetParentModel<ProtoModel *>();
+  // Grandparents hear about it when the parent's own notification is forwarded up (see the constructor).
+  if (_parentModel) _parentModel->QueueChange(0, _parentModel->rowCount() - 1);
+}
+
+void ProtoModel::QueueChange(int first_row, int last_row) {
+  ++notification_stats.requested;
+  if (auto it = pending_change_index.find(this); it != pending_change_index.end()) {
+    PendingChange &change = pending_changes[*it];
+    change.first_row = qMin(change.first_row, first_row);
+    change.last_row = qMax(change.last_row, last_row);
+  } else {
+    pending_change_index.insert(this, pending_changes.size());
+    pending_changes.push_back({this, first_row, last_row});
+  }
+  if (!change_batch_depth && !flush_scheduled) {
+    flush_scheduled = true;
+    QTimer::singleShot(0, &ProtoModel::FlushChanges);
   }
 }
 
+void ProtoModel::FlushChanges() {
+  flush_scheduled = false;
+  // Emitting forwards each model's change to its parent, which queues it again; keep going until nothing is left.
+  while (!pending_changes.empty()) {
+    std::vector<PendingChange> changes;
+    changes.swap(pending_changes);
+    pending_change_index.clear();
+    flushing_changes.push_back(&changes);
+    for (const PendingChange &change : changes) {
+      if (!change.model) continue;
+      ProtoModel *m = change.model;
+      ++notification_stats.emitted;
+      emit m->DataChanged(m->index(change.first_row, 0),
+                          m->index(qMax(change.first_row, change.last_row), m->columnCount() - 1));
+    }
+    flushing_changes.pop_back();
+  }
+}
+
+const ProtoModel::NotificationStats &ProtoModel::GetNotificationStats() { return notification_stats; }
+
+ProtoModel::ChangeBatch::ChangeBatch() { ++change_batch_depth; }
+
+ProtoModel::ChangeBatch::~ChangeBatch() {
+  if (--change_batch_depth == 0) FlushChanges();
+}
+
 void ProtoModel::SetDirty(bool dirty) { _dirty = dirty; }
 
+const ProtoModel *ProtoModel::GetSubModel(const FieldPath::Resolved &field_path) const {
+  const ProtoModel *model = this;
+  if (field_path.repeated_field_index != -1) {
+    const RepeatedModel *repeated = TryCast<RepeatedModel>();
+    R_EXPECT(repeated, nullptr) << "Attempting to index non-repeated model" << DebugName();
+    R_EXPECT(field_path.repeated_field_index < repeated->rowCount(), nullptr)
+        << "Attempting to access out-of-bounds index" << field_path.repeated_field_index << "of" << DebugName();
+    model = repeated->GetSubModel(field_path.repeated_field_index);
+  }
+  for (int i = 0; model && i < field_path.size; ++i) {
+    const FieldDescriptor *field = field_path.fields[i];
+    if (!field) return nullptr;
+    const MessageModel *message = model->TryCast<MessageModel>();
+    R_EXPECT(message, nullptr) << "Attempting to access sub-field" << field->full_name().c_str() << "of"
+                               << model->DebugName();
+    model = message->GetSubModel<ProtoModel>(field->number());
+  }
+  return model;
+}
+
 bool ProtoModel::IsDirty() { return _dirty; }
 
 QIcon LookUpIconByName(const QVariant &name) { return ArtManager::GetIcon(name.toString()); }
@@ -2,6 +2,7 @@
 #define RESOURCEMODEL_H
 
 #include "treenode.pb.h"
+#include "ModelArena.h"
 #include "Utils/FieldPath.h"
 #include "Utils/SafeCasts.h"
 
@@ -27,6 +28,7 @@ using Sound = buffers::resources::Sound;
 using Sprite = buffers::resources::Sprite;
 using Timeline = buffers::resources::Timeline;
 
+class ChangeJournal;
 class ProtoModel;
 class MessageModel;
 class RepeatedModel;
@@ -100,6 +102,10 @@ class ProtoModel : public QAbstractItemModel {
   explicit ProtoModel(NonProtoParent parent, std::string name, const Descriptor *descriptor);
   explicit ProtoModel(ProtoModel *parent, std::string name, const Descriptor *descriptor, int row_in_parent);
 
+  // Models are pooled per project; see ModelArena.
+  static void *operator new(std::size_t size) { return ModelArena::Allocate(size); }
+  static void operator delete(void *ptr) { ModelArena::Free(ptr); }
+
   // The parent model is the model that owns the current model.
   // For the Project model (represented as the resource tree), this will be nullptr.
   // For resource models like a Room, this will be the main Project model.
@@ -109,8 +115,28 @@ class ProtoModel : public QAbstractItemModel {
   ProtoModel *GetParentModel() const { return _parentModel; };
   // If a submodel changed technically any model that owns it has also changed.
   // so we need to notify all parents when anything changes in their descendants.
+  // Notifications to ancestors are coalesced: each model emits at most once per event-loop tick (or per ChangeBatch).
   void ParentDataChanged();
 
+  // Holds back change notifications to ancestor models for its lifetime. Everything queued inside the outermost batch
+  // is merged per model and emitted, once per model, when it closes. Outside of a batch, the same merging happens
+  // once per event-loop tick.
+  class ChangeBatch {
+   public:
+    ChangeBatch();
+    ~ChangeBatch();
+    ChangeBatch(const ChangeBatch &) = delete;
+    ChangeBatch &operator=(const ChangeBatch &) = delete;
+  };
+
+  struct NotificationStats {
+    quint64 requested = 0;  ///< Ancestor notifications that were asked for.
+    quint64 emitted = 0;    ///< Signals actually emitted after merging. (requested - emitted) were saved.
+  };
+  static const NotificationStats &GetNotificationStats();
+  // Emits everything queued so far. Normally called by the event loop or by ChangeBatch.
+  static void FlushChanges();
+
   // A model is "dirty" if the user has made any changes to it since opening the editor.
   // This is mostly used in "Would you like to save?" dialogs when closing editors.
   void SetDirty(bool dirty);
@@ -273,6 +299,25 @@ class ProtoModel : public QAbstractItemModel {
     return const_cast<ProtoModel*>(const_cast<const ProtoModel*>(this)->GetSubModel(field_path));
   }
 
+  // Same as the above, but for pre-resolved paths (see FieldPath::Static). These never allocate.
+  QVariant Data(const FieldPath::Resolved &field_path) const {
+    if (const ProtoModel *sub = GetSubModel(field_path)) return sub->Data();
+    return QVariant();
+  }
+
+  QVariant DataOrDefault(const FieldPath::Resolved &field_path, const QVariant def = QVariant()) const {
+    QVariant ret = Data(field_path);
+    if (ret.isValid()) return ret;
+    else return def;
+  }
+
+  bool SetData(const FieldPath::Resolved &field_path, const QVariant &value) {
+    if (ProtoModel *sub = const_cast<ProtoModel*>(GetSubModel(field_path))) return sub->SetData(value);
+    return false;
+  }
+
+  const ProtoModel *GetSubModel(const FieldPath::Resolved &field_path) const;
+
   virtual QVariant Data() const = 0;
   virtual bool SetData(const QVariant &value) = 0;
   virtual const ProtoModel *GetSubModel(const FieldPath &field_path) const = 0;
@@ -291,11 +336,11 @@ class ProtoModel : public QAbstractItemModel {
   virtual QString DebugName() const = 0;
   const QString &DebugPath() const { return debug_path_;}
 
-  template<typename Model, std::enable_if_t<std::is_base_of_v<ProtoModel, Model>, bool> = false>
-  const Model *ValidateSubModel(const Model *model) const {
-    if (live_pointers_->find(model) != live_pointers_->end()) return model;
-    return nullptr;
-  }
+  // Handle which can be checked for liveness after this model is gone.
+  ModelHandle GetHandle() const { return handle_; }
+  // Returns the model behind the given handle, or null if it has been destroyed (or belongs to another project, whose
+  // arena issued the handle).
+  const ProtoModel *ValidateSubModel(ModelHandle handle) const { return arena_->Lookup(handle); }
 
   virtual MessageModel         *TryCastAsMessageModel()         { return nullptr; }
   virtual RepeatedMessageModel *TryCastAsRepeatedMessageModel() { return nullptr; }
@@ -355,6 +400,12 @@ signals:
   void DataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVariant &oldValue = QVariant(0),
                    const QVector<int> &roles = QVector<int>());
   void ModelConstructed(ProtoModel* model);
+  // Emitted on this model and every ancestor when a field tagged with a resource_ref is edited.
+  // Lets ResourceModelMap keep its reference index current with a single connection on the root.
+  void ResourceReferenceChanged(PrimitiveModel* model, const QString &oldValue);
+  // Emitted on this model and every ancestor when a message which may hold resource references is inserted or restored
+  // beneath it, so that they can be indexed from the buffer without building models for them.
+  void ResourceReferencesAdded(ProtoModel* model, const Message* message);
 
  protected:
   /// Allows child classes to change row_in_parent_ when swapping their own submodels.
@@ -363,6 +414,10 @@ signals:
     std::swap(left, right);
     std::swap(left->row_in_parent_, right->row_in_parent_);
   }
+  /// Same as above, for containers whose submodels are built lazily and may still be null.
+  static void SetRowInParent(ProtoModel *model, int row) {
+    if (model) model->row_in_parent_ = row;
+  }
 
   bool _dirty;
   ProtoModel *_parentModel;
@@ -370,8 +425,16 @@ signals:
   const QString debug_path_;
   const Descriptor *descriptor_;
 
-  // Runtime pointer safety.
-  std::shared_ptr<std::set<ProtoModel const*>> live_pointers_;
+  // Marks the given rows of this model as changed; the signal goes out on the next flush.
+  void QueueChange(int first_row, int last_row);
+
+  // Runtime pointer safety. Shared by every model in the same tree.
+  ModelArena *arena_;
+  ModelHandle handle_;
+
+  friend class ChangeJournal;
+  // Set on the root of a journaled subtree; see ChangeJournal::For.
+  ChangeJournal *journal_ = nullptr;
 
  private:
    static DisplayConfig display_config_;
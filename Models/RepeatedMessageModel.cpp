@@ -1,26 +1,38 @@
 #include "Components/Logger.h"
 #include "RepeatedMessageModel.h"
+#include "ChangeJournal.h"
 #include "MessageModel.h"
 
 RepeatedMessageModel::RepeatedMessageModel(ProtoModel *parent, Message *message, const FieldDescriptor *field)
     : BasicRepeatedModel<Message>(parent, message, field,
                              message->GetReflection()->GetMutableRepeatedFieldRef<Message>(message, field)) {
-  const Reflection *refl = _protobuf->GetReflection();
-  for (int j = 0; j < refl->FieldSize(*_protobuf, field); j++) {
-    _subModels.append(new MessageModel(this, refl->MutableRepeatedMessage(_protobuf, field, j), j));
-  }
+  _subModels.fill(nullptr, field_ref_.size());
+}
+
+MessageModel *RepeatedMessageModel::BuildSubModel(int index) const {
+  auto refl = _protobuf->GetReflection();
+  RepeatedMessageModel *self = const_cast<RepeatedMessageModel *>(this);
+  return _subModels[index] = new MessageModel(self, refl->MutableRepeatedMessage(_protobuf, field_, index), index);
+}
+
+ProtoModel *RepeatedMessageModel::GetSubModel(int index) const {
+  if (index < 0 || index >= _subModels.size()) return nullptr;
+  if (!_subModels[index]) return BuildSubModel(index);
+  return _subModels[index];
 }
 
 void RepeatedMessageModel::SwapWithoutSignal(int left, int right) {
   R_EXPECT_V(left != right) << "Swapping same element";
   BasicRepeatedModel<Message>::SwapWithoutSignal(left, right);
-  SwapModels(_subModels[left], _subModels[right]);
+  std::swap(_subModels[left], _subModels[right]);
+  SetRowInParent(_subModels[left], left);
+  SetRowInParent(_subModels[right], right);
 }
 
 void RepeatedMessageModel::AppendNewWithoutSignal() {
   auto refl = _protobuf->GetReflection();
-  auto m = refl->AddMessage(_protobuf, field_);
-  _subModels.append(new MessageModel(this, m, _subModels.size()));
+  refl->AddMessage(_protobuf, field_);
+  _subModels.append(nullptr);
 }
 
 void RepeatedMessageModel::RemoveLastNRowsWithoutSignal(int n) {
@@ -29,8 +41,10 @@ void RepeatedMessageModel::RemoveLastNRowsWithoutSignal(int n) {
   BasicRepeatedModel<Message>::RemoveLastNRowsWithoutSignal(n);
   size_t idx = _subModels.size() - n;
   for (int i = 0; i < n; ++i) {
-    _subModels.at(idx)->disconnect();
-    _subModels.at(idx)->deleteLater();
+    if (MessageModel *model = _subModels.at(idx)) {
+      model->disconnect();
+      model->deleteLater();
+    }
     idx++;
   }
   _subModels.resize(_subModels.size() - n);
@@ -38,6 +52,7 @@ void RepeatedMessageModel::RemoveLastNRowsWithoutSignal(int n) {
 
 void RepeatedMessageModel::ClearWithoutSignal() {
   for (auto& model : _subModels) {
+    if (!model) continue;
     model->disconnect();
     model->deleteLater();
   }
@@ -48,32 +63,51 @@ void RepeatedMessageModel::ClearWithoutSignal() {
 bool RepeatedMessageModel::setData(const QModelIndex &index, const QVariant &value, int role) {
   R_EXPECT(index.row() >= 0 && index.row() < _subModels.size(), false) <<
     "Supplied row was out of bounds:" << index.row();
-  return _subModels[index.row()]->setData(_subModels[index.row()]->index(index.column()), value, role);
+  auto *model = GetSubModel<MessageModel>(index.row());
+  return model->setData(model->index(index.column()), value, role);
 }
 
 QModelIndex RepeatedMessageModel::insert(const Message &message, int row) {
-  R_EXPECT(row <= rowCount(), QModelIndex()) <<  "Insert message failed";
+  if (!InsertRange(row, {&message})) return QModelIndex();
+  return createIndex(row, 0, this);
+}
 
-  beginInsertRows(QModelIndex(), row, row);
+bool RepeatedMessageModel::InsertRange(int row, const QVector<const Message *> &messages) {
+  R_EXPECT(row >= 0 && row <= rowCount(), false) << "Cannot insert at row " << row << " of " << DebugName();
+  if (messages.isEmpty()) return true;
+  // Checked up front, so that a bad message leaves the field untouched rather than half inserted.
+  for (const Message *message : messages) {
+    R_EXPECT(message && message->GetDescriptor() == field_->message_type(), false)
+        << "Cannot insert a" << (message ? message->GetDescriptor()->full_name().c_str() : "null message")
+        << "into" << DebugName();
+  }
 
-  int p = rowCount();
+  beginInsertRows(QModelIndex(), row, row + messages.size() - 1);
 
-  // Append new row to the list, then move it backwards to where it's supposed to be inserted.
-  AppendNewWithoutSignal();
+  // Copy the messages straight into the buffer; there are no submodels to keep in sync until someone asks for one.
+  auto refl = _protobuf->GetReflection();
+  const int p = rowCount();
+  _subModels.reserve(p + messages.size());
+  for (const Message *message : messages) {
+    refl->AddMessage(_protobuf, field_)->CopyFrom(*message);
+    _subModels.append(nullptr);
+  }
+  // Then move the whole block backwards to where it's supposed to be inserted.
   SwapBackWithoutSignal(row, p, rowCount());
 
-  // Overwrite default-initialized message with the one we are inserting.
-  auto m = GetSubModel(row);
-  R_EXPECT(m, QModelIndex()) << "Requested submodel is null";
-  MessageModel* mm = m->TryCastAsMessageModel();
-  R_EXPECT(mm, QModelIndex()) << "Failed to cast to message model";
-  mm->ReplaceBuffer(&message);
-
   ParentDataChanged();
 
   endInsertRows();
+  if (ChangeJournal *journal = ChangeJournal::For(this)) journal->RecordInsert(this, row, messages.size());
 
-  return createIndex(row, 0, this);
+  if (MessageModel::HasResourceRefs(field_)) {
+    for (int i = row; i < row + messages.size(); ++i) {
+      const Message *added = &refl->GetRepeatedMessage(*_protobuf, field_, i);
+      for (ProtoModel *m = this; m; m = m->GetParentModel()) emit m->ResourceReferencesAdded(this, added);
+    }
+  }
+
+  return true;
 }
 
 QModelIndex RepeatedMessageModel::duplicate(const QModelIndex &message) {
@@ -85,7 +119,7 @@ QModelIndex RepeatedMessageModel::duplicate(const QModelIndex &message) {
 const ProtoModel *RepeatedMessageModel::GetSubModel(const FieldPath &field_path) const {
   if (field_path.repeated_field_index != -1) {
     if (field_path.repeated_field_index < _subModels.size())
-      return _subModels[field_path.repeated_field_index]->GetSubModel(field_path.SkipIndex());
+      return GetSubModel(field_path.repeated_field_index)->GetSubModel(field_path.SkipIndex());
     qDebug() << "Attempting to access out-of-bounds repeated index " << field_path.repeated_field_index
              << " of repeated field `" << field_path.fields[0]->full_name().c_str()
              << "` of size " << _subModels.size();
@@ -105,15 +139,20 @@ bool RepeatedMessageModel::SetData(const QVariant &) {
 }
 
 QVariant RepeatedMessageModel::Data() const {
+  // Read straight from the buffer so this doesn't force every submodel into existence.
+  const Reflection *refl = _protobuf->GetReflection();
   QVector<QVariant> vec;
-  for (const auto *sub_model : _subModels) vec.push_back(sub_model->Data());
+  for (int i = 0; i < field_ref_.size(); i++) {
+    vec.push_back(QVariant::fromValue(AbstractMessage(refl->GetRepeatedMessage(*_protobuf, field_, i))));
+  }
   return QVariant::fromValue(vec);
 }
 
 QVariant RepeatedMessageModel::data(const QModelIndex &index, int role) const {
   R_EXPECT(index.row() >= 0 && index.row() < rowCount(), QVariant())
       << "Row index " << index.row() << " is out of bounds (" << rowCount() << " rows total)";
-  return _subModels[index.row()]->data(_subModels[index.row()]->index(index.column()), role);
+  auto *model = GetSubModel<MessageModel>(index.row());
+  return model->data(model->index(index.column()), role);
 }
 
 int RepeatedMessageModel::columnCount(const QModelIndex & /*parent*/) const {
@@ -124,7 +163,8 @@ Qt::ItemFlags RepeatedMessageModel::flags(const QModelIndex &index) const {
   R_EXPECT(index.row() >= 0 && index.row() < _subModels.size(), RepeatedModel::flags(index)) <<
     "Supplied row was out of bounds:" << index.row();
 
-  return _subModels[index.row()]->flags(_subModels[index.row()]->index(index.column()));
+  auto *model = GetSubModel<MessageModel>(index.row());
+  return model->flags(model->index(index.column()));
 }
 
 const std::string &RepeatedMessageModel::MessageName() const {
@@ -13,11 +13,22 @@ class RepeatedMessageModel : public BasicRepeatedModel<Message> {
   // (e.g. instancesModel->GetSubmodel(3))
   // XXX: Why would anyone try to access these as anything other than MessageModel...?
   template<typename T> auto *GetSubModel(int index) const {
-    return (index < 0 || index >= _subModels.size()) ? nullptr: ((ProtoModel*) _subModels[index])->As<T>();
+    ProtoModel *model = GetSubModel(index);
+    return model ? model->As<T>() : nullptr;
   }
 
-  ProtoModel *GetSubModel(int index) const override {
-    return (index < 0 || index >= _subModels.size()) ? nullptr : (ProtoModel*) _subModels[index];
+  // Submodels are constructed the first time they are requested.
+  ProtoModel *GetSubModel(int index) const override;
+
+  // Typed, read-only access to the message at the given row without building its submodel (see MessageModel).
+  template<typename T> const T *ReadView(int row) const {
+    if (row < 0 || row >= field_ref_.size() || field_->message_type() != T::descriptor()) return nullptr;
+    return static_cast<const T *>(&_protobuf->GetReflection()->GetRepeatedMessage(*_protobuf, field_, row));
+  }
+
+  // Read-only access to the message at the given row, whatever its type, without building its submodel.
+  const Message &MessageAt(int row) const {
+    return _protobuf->GetReflection()->GetRepeatedMessage(*_protobuf, field_, row);
   }
 
   // Translates an underlying Protocol Buffer tag (field number) to the column number from this model.
@@ -54,6 +65,10 @@ class RepeatedMessageModel : public BasicRepeatedModel<Message> {
 
   /// Inserts the given message as a child at the given row.
   QModelIndex insert(const Message &message, int row);
+  /// Inserts copies of all the given messages at the given row, emitting a single rowsInserted.
+  /// Submodels for the new rows are built on demand, like any other row.
+  bool InsertRange(int row, const QVector<const Message *> &messages);
+  using RepeatedModel::InsertRange;
   /// Duplicates the child at the given index. Returns the index of the new (duplicate) node.
   QModelIndex duplicate(const QModelIndex &message);
   // TODO: implement dropping a message
@@ -62,7 +77,11 @@ class RepeatedMessageModel : public BasicRepeatedModel<Message> {
   //const QModelIndex &parent) override;
 
  protected:
-  QVector<MessageModel *> _subModels;
+  // Cache of the submodels built so far; rows which have not been touched yet are null.
+  mutable QVector<MessageModel *> _subModels;
+
+ private:
+  MessageModel *BuildSubModel(int index) const;
 };
 
 #endif
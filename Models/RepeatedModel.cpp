@@ -1,4 +1,5 @@
 #include "RepeatedModel.h"
+#include "ChangeJournal.h"
 #include "Components/Logger.h"
 #include "Components/ArtManager.h"
 
@@ -8,6 +9,8 @@
 
 #include <algorithm>
 
+std::size_t RepeatedModel::RowRemovalOperation::reset_threshold_ = 32;
+
 bool RepeatedModel::setData(const QModelIndex& index, const QVariant& value, int /*role*/) {
   if (index.column() != 0) {
     qDebug() << "Invalid column index";
@@ -19,7 +22,14 @@ bool RepeatedModel::setData(const QModelIndex& index, const QVariant& value, int
     return false;
   }
 
-  return SetDirect(index.row(), value);
+  const QVariant oldValue = GetDirect(index.row());
+  if (!SetDirect(index.row(), value)) return false;
+  SetDirty(true);
+  if (ChangeJournal *journal = ChangeJournal::For(this)) journal->RecordSetRow(this, index.row(), oldValue, value);
+  // Forwarded as dataChanged, as with MessageModel; the parent hears about it through ParentDataChanged.
+  emit DataChanged(index, index, oldValue);
+  ParentDataChanged();
+  return true;
 }
 
 QVariant RepeatedModel::data(const QModelIndex& index, int role) const {
@@ -61,6 +71,16 @@ bool SetData(const QVariant &value) {
   return false;
 }
 
+void RepeatedModel::Clear() {
+  if (ChangeJournal *journal = ChangeJournal::For(this); journal && rowCount() > 0) {
+    journal->RecordRemove(this, {{0, rowCount() - 1}});
+  }
+  beginResetModel();
+  ClearWithoutSignal();
+  endResetModel();
+  ParentDataChanged();
+}
+
 QVariant RepeatedModel::Data() const {
   QVector<QVariant> vec;
   for (int i = 0; i < rowCount(); ++i) vec.push_back(GetDirect(i));
@@ -94,6 +114,7 @@ bool RepeatedModel::moveRows(const QModelIndex &sourceParent, int source, int co
 
   endMoveRows();
   ParentDataChanged();
+  if (ChangeJournal *journal = ChangeJournal::For(this)) journal->RecordMove(this, source, count, destination);
 
   return true;
 }
@@ -145,10 +166,31 @@ bool RepeatedModel::insertRows(int row, int count, const QModelIndex &parent) {
   ParentDataChanged();
 
   endInsertRows();
+  if (ChangeJournal *journal = ChangeJournal::For(this)) journal->RecordInsert(this, row, count);
 
   return true;
 };
 
+bool RepeatedModel::InsertRange(int row, const QVariantList &values) {
+  R_EXPECT(row >= 0 && row <= rowCount(), false) << "Cannot insert at row " << row << " of " << DebugName();
+  if (values.isEmpty()) return true;
+
+  beginInsertRows(QModelIndex(), row, row + values.size() - 1);
+
+  const int p = rowCount();
+  for (int i = 0; i < values.size(); ++i) {
+    AppendNewWithoutSignal();
+    SetDirect(p + i, values[i]);
+  }
+  SwapBackWithoutSignal(row, p, rowCount());
+  ParentDataChanged();
+
+  endInsertRows();
+  if (ChangeJournal *journal = ChangeJournal::For(this)) journal->RecordInsert(this, row, values.size());
+
+  return true;
+}
+
 bool RepeatedModel::removeRows(int position, int count, const QModelIndex& parent) {
   Q_UNUSED(parent);
   RowRemovalOperation remover(this);
@@ -175,6 +217,33 @@ RepeatedModel::RowRemovalOperation::~RowRemovalOperation() {
     }
   }
 
+  // Journaled before anything moves, while the removed rows can still be copied.
+  if (ChangeJournal *journal = ChangeJournal::For(&model_)) {
+    std::vector<std::pair<int, int>> removed;
+    for (const Range &range : ranges) {
+      if (range.last < model_.rowCount()) removed.emplace_back(range.first, range.last);
+    }
+    journal->RecordRemove(&model_, removed);
+  }
+
+  if (ranges.size() <= reset_threshold_) {
+    // Few enough ranges that views are better off hearing about each one. Go back to front so that the rows of the
+    // ranges still to come keep their indices; each range is rotated to the end and dropped.
+    for (auto range = ranges.rbegin(); range != ranges.rend(); ++range) {
+      if (range->last >= model_.rowCount()) {
+        qDebug() << "Cannot remove rows (" << range->first << ", " << range->last << ") from a "
+                 << model_.rowCount() << "-row field";
+        continue;
+      }
+      model_.beginRemoveRows(QModelIndex(), range->first, range->last);
+      model_.SwapBackWithoutSignal(range->first, range->last + 1, model_.rowCount());
+      model_.RemoveLastNRowsWithoutSignal(range->size());
+      model_.endRemoveRows();
+    }
+    model_.ParentDataChanged();
+    return;
+  }
+
   model_.beginResetModel();
 
   // Basic dense range removal. Move "deleted" rows to the end of the array.
@@ -276,7 +345,7 @@ bool RepeatedModel::dropMimeData(const QMimeData* data, Qt::DropAction action, i
 
   QByteArray encodedData = data->data(mime);
   QDataStream stream(&encodedData, QIODevice::ReadOnly);
-  QStringList newItems;
+  QVariantList newItems;
 
   while (!stream.atEnd()) {
     QString text;
@@ -285,12 +354,8 @@ bool RepeatedModel::dropMimeData(const QMimeData* data, Qt::DropAction action, i
   }
 
   qDebug() << "State before insert: " << DataDebugString();
-  insertRows(beginRow, newItems.size(), QModelIndex());
-  qDebug() << "State after insert, before overwrite: " << DataDebugString();
-  foreach (const QString& text, newItems) {
-    SetDirect(beginRow++, text);
-  }
-  qDebug() << "State after overwrite: " << DataDebugString();
+  InsertRange(beginRow, newItems);
+  qDebug() << "State after insert: " << DataDebugString();
 
   return true;
 }
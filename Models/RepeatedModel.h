@@ -46,12 +46,7 @@ class RepeatedModel : public ProtoModel {
     return field_;
   }
 
-  void Clear() {
-    beginResetModel();
-    ClearWithoutSignal();
-    endResetModel();
-    ParentDataChanged();
-  }
+  void Clear();
 
   const google::protobuf::FieldDescriptor *GetFieldDescriptor() const { return field_; }
 
@@ -102,6 +97,9 @@ class RepeatedModel : public ProtoModel {
   // Convenience function for internal moves
   bool moveRows(int source, int count, int destination);
   bool insertRows(int row, int count, const QModelIndex &parent = QModelIndex()) override;
+  // Inserts all of the given values at `row` and emits a single rowsInserted. The new block is appended and rotated
+  // into place in one pass, so this costs O(rows + values) rather than O(rows * values).
+  bool InsertRange(int row, const QVariantList &values);
   bool removeRows(int position, int count, const QModelIndex& parent = QModelIndex()) override;
   QMimeData *mimeData(const QModelIndexList &indexes) const override;
   bool dropMimeData(const QMimeData *data, Qt::DropAction action, int row, int column,
@@ -129,11 +127,19 @@ class RepeatedModel : public ProtoModel {
     RowRemovalOperation(const RowRemovalOperation&) = delete;
     RowRemovalOperation(RowRemovalOperation&&) = default;
     /// This method completes the row removal.
+    /// Each contiguous range of removed rows is announced with its own beginRemoveRows/endRemoveRows, unless there
+    /// are more ranges than the reset threshold, in which case the model is reset instead.
     ~RowRemovalOperation();
 
+    /// Sets the number of distinct row ranges above which removals fall back to a model reset.
+    static void SetResetThreshold(std::size_t ranges) { reset_threshold_ = ranges; }
+    static std::size_t ResetThreshold() { return reset_threshold_; }
+
    private:
     std::set<int> rows_;
     RepeatedModel &model_;
+
+    static std::size_t reset_threshold_;
   };
 
  protected:
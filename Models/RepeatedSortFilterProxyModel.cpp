@@ -22,6 +22,23 @@ QVariant RepeatedSortFilterProxyModel::DataOrDefault(FieldPath field_path, const
   return model_->DataOrDefault(FieldPath{source_row, field_path.fields}, def);
 }
 
+QVariant RepeatedSortFilterProxyModel::Data(const FieldPath::Resolved &field_path) const {
+  return DataOrDefault(field_path);
+}
+
+QVariant RepeatedSortFilterProxyModel::DataOrDefault(const FieldPath::Resolved &field_path, const QVariant def) const {
+  R_EXPECT(model_, QVariant()) << "Internal model null";
+
+  auto idx = index(field_path.repeated_field_index, 0);
+
+  R_EXPECT(field_path.repeated_field_index != -1 && idx.isValid() && idx.internalPointer(), QVariant())
+      << "Invalid index" << idx;
+
+  FieldPath::Resolved source_path = field_path;
+  source_path.repeated_field_index = mapToSource(idx).row();
+  return model_->DataOrDefault(source_path, def);
+}
+
 ProtoModel* RepeatedSortFilterProxyModel::GetSubModel(int fieldNum) const {
   R_EXPECT(model_, nullptr) << "Internal model null";
   int source_row = mapToSource(index(fieldNum, 0)).row();
@@ -13,11 +13,21 @@ class RepeatedSortFilterProxyModel : public QSortFilterProxyModel {
   void SetSourceModel(RepeatedModel *sourceModel);
   QVariant Data(FieldPath field_path) const;
   QVariant DataOrDefault(FieldPath field_path, const QVariant def = QVariant()) const;
+  QVariant Data(const FieldPath::Resolved &field_path) const;
+  QVariant DataOrDefault(const FieldPath::Resolved &field_path, const QVariant def = QVariant()) const;
   ProtoModel* GetSubModel(int fieldNum) const;
 
+  // Typed view of the message at the given (sorted) row. See RepeatedMessageModel::ReadView.
+  template <typename T>
+  const T* ReadView(int row) const {
+    RepeatedMessageModel* messages = model_ ? model_->TryCastAsRepeatedMessageModel() : nullptr;
+    if (!messages) return nullptr;
+    return messages->ReadView<T>(mapToSource(index(row, 0)).row());
+  }
+
 protected:
   void setSourceModel(QAbstractItemModel* /*sourceModel*/) override {}
-  RepeatedModel* model_;
+  RepeatedModel* model_ = nullptr;
 };
 
 #endif  // REPEATEDSORTFILTERPROXYMODEL_H
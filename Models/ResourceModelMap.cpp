@@ -1,8 +1,12 @@
 #include "Models/ResourceModelMap.h"
 #include "Editors/BaseEditor.h"
 #include "MainWindow.h"
+#include "Models/ChangeJournal.h"
 #include "Models/RepeatedMessageModel.h"
 
+#include <algorithm>
+#include <vector>
+
 static std::string ResTypeAsString(TypeCase type) {
   switch (type) {
     case TypeCase::kFolder: return "treenode";
@@ -26,20 +30,21 @@ static std::string ResTypeAsString(TypeCase type) {
 
 ResourceModelMap::ResourceModelMap(QObject* parent) : QObject(parent) {}
 
-static void TreeChangedHelper(MessageModel* model, ResourceModelMap* rm) {
+// Calls visit(type, name, model) for the given tree node and every node below it, groups included.
+template <typename Visitor>
+static void VisitTreeNodes(MessageModel* model, const Visitor& visit) {
+  if (!model) return;
+  const TreeNode* node = model->ReadView<TreeNode>();
+  if (!node) return;
+  visit(node->type_case(), QString::fromStdString(node->name()), model);
+  if (!node->has_folder()) return;
   const MessageModel* folder = model->GetSubModel<MessageModel*>(TreeNode::kFolderFieldNumber);
-  if (folder) {
-    const RepeatedMessageModel* children =
-        folder->GetSubModel<RepeatedMessageModel*>(TreeNode::Folder::kChildrenFieldNumber);
-    if (children) {
-      for (int i = 0; i < children->rowCount(); ++i) {
-        TreeChangedHelper(children->GetSubModel(i)->TryCastAsMessageModel(), rm);
-      }
-    }
-  } else {
-    int type = model->OneOfType("type");
-    rm->AddResource((buffers::TreeNode::TypeCase)type,
-                    model->Data(FieldPath::Of<TreeNode>(TreeNode::kNameFieldNumber)).toString(), model);
+  if (!folder) return;
+  const RepeatedMessageModel* children =
+      folder->GetSubModel<RepeatedMessageModel*>(TreeNode::Folder::kChildrenFieldNumber);
+  if (!children) return;
+  for (int i = 0; i < children->rowCount(); ++i) {
+    VisitTreeNodes(children->GetSubModel(i)->TryCastAsMessageModel(), visit);
   }
 }
 
@@ -49,88 +54,159 @@ void ResourceModelMap::dataChanged(const QModelIndex &topLeft, const QModelIndex
 
 void ResourceModelMap::TreeChanged(MessageModel* model) {
   _resources.clear();
-  TreeChangedHelper(model, this);
+  _resourceKeys.clear();
+  _nextSuffix.clear();
+  _references.clear();
+  VisitTreeNodes(model, [this](TypeCase type, const QString& name, MessageModel* m) { AddResource(type, name, m); });
+}
+
+// Gathers the models of the given node and every node below it, without reading their (possibly stale) data.
+static void CollectMessageModels(TreeModel::Node* node, QSet<MessageModel*>* models) {
+  if (!node) return;
+  if (MessageModel* model = node->GetMessageModel()) models->insert(model);
+  for (const auto& child : node->children) CollectMessageModels(child.get(), models);
+}
+
+// Calls visit(type, name, model) for the resources shown by the given node and below.
+template <typename Visitor>
+static void VisitNode(TreeModel::Node* node, const Visitor& visit) {
+  if (!node) return;
+  if (MessageModel* model = node->GetMessageModel()) return VisitTreeNodes(model, visit);
+  for (const auto& child : node->children) VisitNode(child.get(), visit);
+}
+
+void ResourceModelMap::TrackTree(TreeModel* tree) {
+  const auto add = [this](TypeCase type, const QString& name, MessageModel* m) { AddResource(type, name, m); };
+  connect(tree, &TreeModel::rowsInserted, this, [tree, add](const QModelIndex& parent, int first, int last) {
+    for (int row = first; row <= last; ++row) VisitNode(tree->IndexToNode(tree->index(row, 0, parent)), add);
+  });
+  // The backing rows are already gone by the time the tree splices its nodes out, so names can't be read here; the
+  // nodes still know their models, though. Deletes and moves normally went through ResourceRemoved() first.
+  connect(tree, &TreeModel::rowsAboutToBeRemoved, this, [this, tree](const QModelIndex& parent, int first, int last) {
+    QSet<MessageModel*> removed;
+    for (int row = first; row <= last; ++row) {
+      CollectMessageModels(tree->IndexToNode(tree->index(row, 0, parent)), &removed);
+    }
+    if (!removed.isEmpty()) ForgetResources(removed);
+  });
+  // A node rebuilt from its model (e.g. after an editor reverts, or a removal too scattered to splice) is refiled on
+  // its own; only a reset of the whole tree needs a full pass.
+  connect(tree, &TreeModel::layoutAboutToBeChanged, this, [this, tree](const QList<QPersistentModelIndex>& parents) {
+    QSet<MessageModel*> removed;
+    for (const QPersistentModelIndex& parent : parents) CollectMessageModels(tree->IndexToNode(parent), &removed);
+    if (!removed.isEmpty()) ForgetResources(removed);
+  });
+  connect(tree, &TreeModel::layoutChanged, this, [tree, add](const QList<QPersistentModelIndex>& parents) {
+    for (const QPersistentModelIndex& parent : parents) VisitNode(tree->IndexToNode(parent), add);
+  });
+  connect(tree, &TreeModel::modelReset, this, [this, tree]() {
+    if (TreeModel::Node* root = tree->IndexToNode(QModelIndex())) TreeChanged(root->GetMessageModel());
+  });
+}
+
+void ResourceModelMap::ForgetResources(const QSet<MessageModel*>& models) {
+  for (MessageModel* model : models) {
+    auto key = _resourceKeys.find(model);
+    if (key == _resourceKeys.end()) continue;
+    auto it = _resources[key->first].find(key->second);
+    if (it != _resources[key->first].end() && *it == model) _resources[key->first].erase(it);
+    _resourceKeys.erase(key);
+  }
+}
+
+void ResourceModelMap::ForgetResource(TypeCase type, const QString& name, MessageModel* model) {
+  auto it = _resources[type].find(name);
+  if (it == _resources[type].end() || *it != model) return;
+  _resources[type].erase(it);
+  _resourceKeys.remove(model);
 }
 
 void ResourceModelMap::AddResource(TypeCase type, const QString& name, MessageModel* model) {
+  NoteName(type, name);
+  // Groups only contribute to name generation; their names need not be unique.
+  if (type == TypeCase::kFolder) return;
   R_EXPECT_V(!_resources[type].contains(name))
       << "Resource" << ResTypeAsString(type) << "with name:" << name << "already exists";
   _resources[type][name] = model;
+  _resourceKeys.insert(model, {type, name});
+  if (const Message* buffer = model->GetBuffer()) IndexReferences(model, *buffer);
+}
+
+void ResourceModelMap::NoteName(int type, const QString& name) {
+  int digits = 0;
+  while (digits < name.size() && name[name.size() - 1 - digits].isDigit()) ++digits;
+  if (digits == 0 || digits > 9) return;
+  int& next = _nextSuffix[type][name.left(name.size() - digits)];
+  next = std::max(next, name.right(digits).toInt() + 1);
+}
+
+using InstanceObjectType = FieldPath::Static<Room::Instance, Room::Instance::kObjectTypeFieldNumber>;
+using TileBackgroundName = FieldPath::Static<Room::Tile, Room::Tile::kBackgroundNameFieldNumber>;
+
+// Whether the message holding this reference should be deleted along with the resource it names,
+// rather than just having the reference cleared (e.g. instances of a deleted object).
+static bool RemovedWithResource(const FieldDescriptor* field) {
+  static const FieldDescriptor* const kInstanceObjectType = InstanceObjectType::Descriptors().back();
+  static const FieldDescriptor* const kTileBackgroundName = TileBackgroundName::Descriptors().back();
+  return field == kInstanceObjectType || field == kTileBackgroundName;
+}
+
+// An open editor can revert the room to how it was when it was opened, which may still use the resource. Its journal
+// can't replay around a removal it didn't make, so the opening state is materialized and patched directly. That
+// state isn't part of the project tree, so the reference index doesn't cover it; there are only ever a handful.
+template <typename ReferencePath>
+static void RemoveFromBackup(MessageModel* roomModel, int listField, const QString& name,
+                             std::map<ProtoModel*, RepeatedMessageModel::RowRemovalOperation>& removers) {
+  ChangeJournal* journal = roomModel->GetJournal();
+  MessageModel* backupModel = journal ? journal->BaseModel() : nullptr;
+  if (backupModel == nullptr) return;
+  RepeatedMessageModel* listModel = backupModel->GetSubModel<RepeatedMessageModel*>(listField);
+  R_EXPECT_V(listModel);
+  auto& remover = removers.emplace(listModel, listModel).first->second;
+  for (int row = 0; row < listModel->rowCount(); ++row) {
+    if (listModel->Data(ReferencePath(row)).toString() == name) remover.RemoveRow(row);
+  }
 }
 
 void ResourceModelMap::ResourceRemoved(TypeCase type, const QString& name,
                                       std::map<ProtoModel*, RepeatedMessageModel::RowRemovalOperation>& removers) {
   if (type == TypeCase::kFolder || !_resources.contains(type)) return;
   if (!_resources[type].contains(name)) return;
-
-  // Delete all instances of this object type
-  if (type == TypeCase::kObject) {
-    for (auto& room : qAsConst(_resources[TypeCase::kRoom])) {
-      R_EXPECT_V(room);
-      MessageModel* roomModel = room->GetSubModel<MessageModel*>(TreeNode::kRoomFieldNumber);
-      R_EXPECT_V(roomModel);
-      RepeatedMessageModel* instancesModel = roomModel->GetSubModel<RepeatedMessageModel*>(Room::kInstancesFieldNumber);
-      auto& remover = removers.emplace(instancesModel, instancesModel).first->second;
-
-      for (int row = 0; row < instancesModel->rowCount(); ++row) {
-        if (instancesModel
-                ->Data(
-                    FieldPath::Of<Room::Instance>(FieldPath::StartingAt(row), Room::Instance::kObjectTypeFieldNumber))
-                .toString() == name)
-          remover.RemoveRow(row);
-      }
-
-      // Only models in use in open editors should have backup models
-      MessageModel* backupModel = roomModel->GetBackupModel();
-      if (backupModel != nullptr) {
-        RepeatedMessageModel* instancesModelBak =
-            backupModel->GetSubModel<RepeatedMessageModel*>(Room::kInstancesFieldNumber);
-        auto& remover = removers.emplace(instancesModelBak, instancesModelBak).first->second;
-
-        for (int row = 0; row < instancesModelBak->rowCount(); ++row) {
-          if (instancesModelBak
-                  ->Data(
-                      FieldPath::Of<Room::Instance>(FieldPath::StartingAt(row), Room::Instance::kObjectTypeFieldNumber))
-                  .toString() == name)
-            remover.RemoveRow(row);
-        }
-      }
+  const std::string typeName = ResTypeAsString(type);
+  MessageModel* const removed = _resources[type][name];
+
+  // Delete all instances of this object type and all tiles using this background
+  for (PrimitiveModel* reference : GetReferences(typeName, name)) {
+    if (!RemovedWithResource(reference->GetFieldDescriptor())) continue;
+    ProtoModel* owner = reference->GetParentModel();
+    ProtoModel* ownerList = owner->GetParentModel();
+    RepeatedMessageModel* listModel = ownerList ? ownerList->TryCastAsRepeatedMessageModel() : nullptr;
+    if (!listModel) {
+      qDebug() << "Reference" << reference->DebugName() << "is not part of a repeated field";
+      continue;
     }
+    removers.emplace(listModel, listModel).first->second.RemoveRow(owner->RowInParent());
   }
 
-  // Delete all tiles using this background
-  if (type == TypeCase::kBackground) {
+  if (type == TypeCase::kObject || type == TypeCase::kBackground) {
     for (auto& room : qAsConst(_resources[TypeCase::kRoom])) {
+      R_EXPECT_V(room);
       MessageModel* roomModel = room->GetSubModel<MessageModel*>(TreeNode::kRoomFieldNumber);
-      RepeatedMessageModel* tilesModel = roomModel->GetSubModel<RepeatedMessageModel*>(Room::kTilesFieldNumber);
-      auto& remover = removers.emplace(tilesModel, tilesModel).first->second;
-
-      for (int row = 0; row < tilesModel->rowCount(); ++row) {
-        if (tilesModel
-                ->Data(
-                    FieldPath::Of<Room::Instance>(FieldPath::StartingAt(row), Room::Instance::kObjectTypeFieldNumber))
-                .toString() == name)
-          remover.RemoveRow(row);
-      }
-
-      // Only models in use in open editors should have backup models
-      MessageModel* backupModel = roomModel->GetBackupModel();
-      if (backupModel != nullptr) {
-        RepeatedMessageModel* tilesModelBak = backupModel->GetSubModel<RepeatedMessageModel*>(Room::kTilesFieldNumber);
-        auto& remover = removers.emplace(tilesModelBak, tilesModelBak).first->second;
-
-        for (int row = 0; row < tilesModelBak->rowCount(); ++row) {
-          if (tilesModelBak
-                  ->Data(FieldPath::Of<Room::Tile>(FieldPath::StartingAt(row), Room::Tile::kBackgroundNameFieldNumber))
-                  .toString() == name)
-            remover.RemoveRow(row);
-        }
-      }
+      R_EXPECT_V(roomModel);
+      if (type == TypeCase::kObject)
+        RemoveFromBackup<InstanceObjectType>(roomModel, Room::kInstancesFieldNumber, name, removers);
+      else
+        RemoveFromBackup<TileBackgroundName>(roomModel, Room::kTilesFieldNumber, name, removers);
     }
   }
 
   // Remove an references to this resource
-  emit ResourceRenamed(ResTypeAsString(type), name, "");
+  UpdateReferences(typeName, name, "");
+  emit ResourceRenamed(typeName, name, "");
+
+  // Forget the resource while its name is still known; the removers take its row out afterward. A listener may have
+  // already replaced the entry, so only drop it if it is still this resource.
+  ForgetResource(type, name, removed);
 }
 
 QString ResourceModelMap::CreateResourceName(TreeNode* node) {
@@ -142,11 +218,11 @@ QString ResourceModelMap::CreateResourceName(TreeNode* node) {
 }
 
 QString ResourceModelMap::CreateResourceName(int type, const QString& typeName) {
-  const QString pre = typeName;
+  // Start past the highest number already in use with this prefix, rather than probing from zero every time.
+  int& next = _nextSuffix[type][typeName];
   QString name;
-  int i = 0;
   do {
-    name = pre + QString::number(i++);
+    name = typeName + QString::number(next++);
   } while (_resources[type].contains(name));
   return name;
 }
@@ -197,14 +273,128 @@ TypeCase Type(TreeModel::Node* node) {
 
 void ResourceModelMap::ResourceRenamed(TypeCase type, const QString& oldName, const QString& newName) {
   if (oldName == newName || !_resources[type].contains(oldName)) return;
-  _resources[type][newName] = _resources[type][oldName];
-
-  emit ResourceRenamed(ResTypeAsString(type), oldName, newName);
+  MessageModel* model = _resources[type][oldName];
+  _resources[type][newName] = model;
+  _resourceKeys.insert(model, {type, newName});
+  NoteName(type, newName);
+
+  const std::string typeName = ResTypeAsString(type);
+  UpdateReferences(typeName, oldName, newName);
+  emit ResourceRenamed(typeName, oldName, newName);
   _resources[type].remove(oldName);
 
   emit DataChanged();
 }
 
+// Calls visit(type, name, path) for each non-empty field tagged with a resource_ref in the given message, reading only
+// the buffer. `path` leads from the message to the field, so that the field's model can be built if it is wanted.
+template <typename Visitor>
+static void VisitReferences(const Message& message, std::vector<FieldPath::FieldComponent>* path,
+                            const Visitor& visit) {
+  const Descriptor* desc = message.GetDescriptor();
+  const Reflection* refl = message.GetReflection();
+  for (int i = 0; i < desc->field_count(); ++i) {
+    const FieldDescriptor* field = desc->field(i);
+    if (!MessageModel::HasResourceRefs(field)) continue;
+    if (field->cpp_type() == CppType::CPPTYPE_MESSAGE) {
+      if (field->is_repeated()) {
+        for (int j = 0; j < refl->FieldSize(message, field); ++j) {
+          path->emplace_back(field, j);
+          VisitReferences(refl->GetRepeatedMessage(message, field, j), path, visit);
+          path->pop_back();
+        }
+      } else if (refl->HasField(message, field)) {
+        path->emplace_back(field);
+        VisitReferences(refl->GetMessage(message, field), path, visit);
+        path->pop_back();
+      }
+    } else if (field->cpp_type() == CppType::CPPTYPE_STRING && !field->is_repeated()) {
+      std::string scratch;
+      const std::string& name = refl->GetStringReference(message, field, &scratch);
+      if (name.empty()) continue;
+      path->emplace_back(field);
+      visit(field->options().GetExtension(buffers::resource_ref), QString::fromStdString(name), *path);
+      path->pop_back();
+    }
+  }
+}
+
+void ResourceModelMap::IndexReferences(MessageModel* resource, const Message& message) {
+  std::vector<FieldPath::FieldComponent> path;
+  VisitReferences(message, &path, [this, resource](const std::string& type, const QString& name, const auto&) {
+    _references[type][name].insert(resource);
+  });
+}
+
+MessageModel* ResourceModelMap::OwningResource(ProtoModel* model) const {
+  for (; model; model = model->GetParentModel()) {
+    MessageModel* message = model->TryCastAsMessageModel();
+    if (message && _resourceKeys.contains(message)) return message;
+  }
+  return nullptr;
+}
+
+void ResourceModelMap::ReferenceChanged(PrimitiveModel* model) {
+  // The entry under the old name is left for GetReferences() to drop, as the resource may still name it elsewhere.
+  const FieldDescriptor* field = model->GetFieldDescriptor();
+  if (!field) return;
+  const std::string& type = field->options().GetExtension(buffers::resource_ref);
+  const QString name = model->GetAsQString();
+  if (type.empty() || name.isEmpty()) return;
+  if (MessageModel* resource = OwningResource(model)) _references[type][name].insert(resource);
+}
+
+void ResourceModelMap::ReferencesAdded(ProtoModel* model, const Message* message) {
+  // A resource inserted into the tree isn't known yet; AddResource() indexes the whole of it instead.
+  if (MessageModel* resource = OwningResource(model)) IndexReferences(resource, *message);
+}
+
+QVector<PrimitiveModel*> ResourceModelMap::GetReferences(const std::string& type, const QString& name) {
+  QVector<PrimitiveModel*> references;
+  auto byType = _references.find(type);
+  if (byType == _references.end()) return references;
+  auto byName = byType->second.find(name);
+  if (byName == byType->second.end()) return references;
+
+  for (auto it = byName->begin(); it != byName->end();) {
+    // Drop resources which have since been removed, or which no longer name this one (e.g. a restored backup).
+    MessageModel* resource = *it;
+    const int found = references.size();
+    if (_resourceKeys.contains(resource)) {
+      const auto collect = [&](const std::string& refType, const QString& refName,
+                               const std::vector<FieldPath::FieldComponent>& fields) {
+        if (refType != type || refName != name) return;
+        ProtoModel* model = static_cast<ProtoModel*>(resource)->GetSubModel(FieldPath(fields));
+        PrimitiveModel* reference = model ? model->TryCastAsPrimitiveModel() : nullptr;
+        if (reference) references.append(reference);
+      };
+      std::vector<FieldPath::FieldComponent> path;
+      VisitReferences(*resource->GetBuffer(), &path, collect);
+    }
+    if (references.size() == found) {
+      it = byName->erase(it);
+    } else {
+      ++it;
+    }
+  }
+  if (byName->isEmpty()) byType->second.erase(byName);
+  return references;
+}
+
+void ResourceModelMap::UpdateReferences(const std::string& type, const QString& oldName, const QString& newName) {
+  const QVector<PrimitiveModel*> references = GetReferences(type, oldName);
+  if (references.isEmpty()) return;
+  // Reverting an editor mustn't bring back a name which no longer exists.
+  ChangeJournal::ExternalEdit external;
+  // The edits below don't signal, so the holders are moved across here.
+  auto& byName = _references[type];
+  const QSet<MessageModel*> holders = byName.take(oldName);
+  if (!newName.isEmpty()) byName[newName].unite(holders);
+  for (PrimitiveModel* model : references) {
+    model->ExtensionChanged<decltype(buffers::resource_ref)>(buffers::resource_ref, type, oldName, newName);
+  }
+}
+
 MessageModel* GetObjectSprite(const std::string& object_name) {
   return GetObjectSprite(QString::fromStdString(object_name));
 }
@@ -214,8 +404,9 @@ MessageModel* GetObjectSprite(const QString& object_name) {
   if (!obj) return nullptr;
   obj = obj->GetSubModel<MessageModel*>(TreeNode::kObjectFieldNumber);
   if (!obj) return nullptr;
-  const QString spriteName = obj->Data(FieldPath::Of<Object>(Object::kSpriteNameFieldNumber)).toString();
-  MessageModel* spr = MainWindow::resourceMap->GetResourceByName(TreeNode::kSprite, spriteName);
+  const Object* object = obj->ReadView<Object>();
+  if (!object) return nullptr;
+  MessageModel* spr = MainWindow::resourceMap->GetResourceByName(TreeNode::kSprite, object->sprite_name());
   if (spr) return spr->GetSubModel<MessageModel*>(TreeNode::kSpriteFieldNumber);
   return nullptr;
 }
@@ -233,7 +424,7 @@ QIcon GetSpriteIconByName(const QString& sprite_name) {
   if (subimgs->rowCount() == 0) return {};
   QVariant path = subimgs->DataAtRow(0);
   if (path.isNull()) return {};
-  return ArtManager::GetIcon(path.toString());
+  return ArtManager::GetThumbnail(path.toString());
 }
 
 QIcon GetObjectSpriteByNameField(const QVariant& object_name) {
@@ -251,7 +442,7 @@ QIcon GetBackgroundIconByNameField(const QVariant& bkg_name) {
   if (!bkg) return QIcon();
   bkg = bkg->GetSubModel<MessageModel*>(TreeNode::kBackgroundFieldNumber);
   if (!bkg) return QIcon();
-  return ArtManager::GetIcon(bkg->Data(FieldPath::Of<Background>(Background::kImageFieldNumber)).toString());
+  return ArtManager::GetThumbnail(bkg->Data(FieldPath::Of<Background>(Background::kImageFieldNumber)).toString());
 }
 
-QIcon GetFileIcon(const QVariant& fname) { return ArtManager::GetIcon(fname.toString()); }
+QIcon GetFileIcon(const QVariant& fname) { return ArtManager::GetThumbnail(fname.toString()); }
@@ -5,9 +5,12 @@
 #include "TreeModel.h"
 
 #include <QHash>
+#include <QPair>
 #include <QIcon>
+#include <QSet>
 #include <QVector>
 #include <string>
+#include <unordered_map>
 
 class ResourceModelMap : public QObject {
   Q_OBJECT
@@ -19,6 +22,12 @@ class ResourceModelMap : public QObject {
   QString CreateResourceName(TreeNode* node);
   QString CreateResourceName(int type, const QString& typeName);
   bool ValidName(TypeCase type, const QString& name);
+  /// Keeps the map up to date as rows are inserted into or removed from the given tree, instead of rebuilding it.
+  void TrackTree(TreeModel* tree);
+
+  /// Returns the fields which currently name the given resource. Only the resources indexed as naming it are searched,
+  /// and only the models of the matching fields are built. `type` is the resource_ref type (e.g. "sprite").
+  QVector<PrimitiveModel*> GetReferences(const std::string& type, const QString& name);
 
  public slots:
   void dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles = QVector<int>());
@@ -26,6 +35,10 @@ class ResourceModelMap : public QObject {
   void ResourceRenamed(TypeCase type, const QString& oldName, const QString& newName);
   void ResourceRemoved(TypeCase type, const QString& name,
                       std::map<ProtoModel*, RepeatedModel::RowRemovalOperation>& removers);
+  /// Files the resource holding a just-edited reference field under the name the field now holds.
+  void ReferenceChanged(PrimitiveModel* model);
+  /// Indexes the references in a message just inserted or restored beneath the given model.
+  void ReferencesAdded(ProtoModel* model, const Message* message);
 
  signals:
   void DataChanged();
@@ -33,6 +46,28 @@ class ResourceModelMap : public QObject {
 
  protected:
   QHash<int, QHash<QString, MessageModel*>> _resources;
+  // The type and name each model in _resources is filed under, so that a removed model can be found without a scan.
+  QHash<MessageModel*, QPair<TypeCase, QString>> _resourceKeys;
+  // For each type and name prefix, one past the highest numeric suffix seen (e.g. sprite12 makes "sprite" 13).
+  QHash<int, QHash<QString, int>> _nextSuffix;
+  // Reverse index from resource_ref type and resource name to the resources whose buffers named it when indexed.
+  // It is filled by walking buffers, so no field models are built for it. Entries are checked on lookup, so resources
+  // which have since been removed or no longer name it simply drop out.
+  std::unordered_map<std::string, QHash<QString, QSet<MessageModel*>>> _references;
+
+ private:
+  /// Records a name's numeric suffix so that CreateResourceName() can skip past it.
+  void NoteName(int type, const QString& name);
+  /// Drops every resource whose model is among those given, whatever name it was filed under.
+  void ForgetResources(const QSet<MessageModel*>& models);
+  /// Drops the resource filed under this type and name, if it is still the given model.
+  void ForgetResource(TypeCase type, const QString& name, MessageModel* model);
+  /// Files the resource under every name its references in the given message hold.
+  void IndexReferences(MessageModel* resource, const Message& message);
+  /// Returns the resource the given model belongs to, or null if it isn't part of one.
+  MessageModel* OwningResource(ProtoModel* model) const;
+  /// Points every field naming oldName at newName instead (or clears them, if newName is empty).
+  void UpdateReferences(const std::string& type, const QString& oldName, const QString& newName);
 };
 
 MessageModel* GetObjectSprite(const std::string& object_name);
@@ -0,0 +1,77 @@
+#include "SnapshotCache.h"
+#include "RepeatedMessageModel.h"
+
+using buffers::TreeNode;
+
+ProjectSnapshot SnapshotCache::Take(buffers::Project *project, MessageModel *root) {
+  // Edits still waiting to be announced would otherwise leave their resources looking unchanged.
+  ProtoModel::FlushChanges();
+
+  ProjectSnapshot snapshot;
+  // Everything but the tree is copied as is. The tree is moved aside for it and straight back, which swaps pointers
+  // rather than copying, so the models over it never see a change.
+  TreeNode tree;
+  tree.Swap(project->mutable_game()->mutable_root());
+  snapshot.project = std::make_unique<buffers::Project>(*project);
+  tree.Swap(project->mutable_game()->mutable_root());
+
+  QHash<MessageModel *, Entry> kept;
+  Visit(root, snapshot.project->mutable_game()->mutable_root(), &snapshot, &kept);
+  // Whatever wasn't visited belongs to resources which are gone.
+  Clear();
+  _entries.swap(kept);
+  return snapshot;
+}
+
+void SnapshotCache::Clear() {
+  for (const Entry &entry : qAsConst(_entries)) {
+    disconnect(entry.edited);
+    disconnect(entry.reset);
+  }
+  _entries.clear();
+}
+
+void SnapshotCache::Forget(MessageModel *model) {
+  auto it = _entries.find(model);
+  if (it == _entries.end()) return;
+  disconnect(it->edited);
+  disconnect(it->reset);
+  _entries.erase(it);
+}
+
+void SnapshotCache::Visit(MessageModel *model, TreeNode *node, ProjectSnapshot *snapshot,
+                          QHash<MessageModel *, Entry> *kept) {
+  if (!model) return;
+  TreeNode *buffer = static_cast<TreeNode *>(model->GetBuffer());
+  if (!buffer->has_folder()) {
+    auto it = _entries.find(model);
+    // A model freed and another allocated in its place is not the same resource.
+    if (it == _entries.end() || it->model != model) {
+      Forget(model);
+      Entry entry{model, std::make_shared<const TreeNode>(*buffer), {}, {}};
+      // Any edit beneath the resource is forwarded up to its model, so these are the only connections needed.
+      entry.edited = connect(model, &ProtoModel::dataChanged, this, [this, model]() { Forget(model); });
+      entry.reset = connect(model, &ProtoModel::modelReset, this, [this, model]() { Forget(model); });
+      it = _entries.insert(model, entry);
+    }
+    snapshot->resources.emplace_back(node, it->copy);
+    kept->insert(model, *it);
+    _entries.erase(it);
+    return;
+  }
+
+  // Groups are copied without their children, which are visited one by one instead. Like the tree above, the
+  // children are moved aside for the copy rather than copied.
+  google::protobuf::RepeatedPtrField<TreeNode> children;
+  children.Swap(buffer->mutable_folder()->mutable_children());
+  *node = *buffer;
+  children.Swap(buffer->mutable_folder()->mutable_children());
+
+  MessageModel *folder = model->GetSubModel<MessageModel *>(TreeNode::kFolderFieldNumber);
+  RepeatedMessageModel *list =
+      folder ? folder->GetSubModel<RepeatedMessageModel *>(TreeNode::Folder::kChildrenFieldNumber) : nullptr;
+  if (!list) return;
+  for (int row = 0; row < list->rowCount(); ++row) {
+    Visit(list->GetSubModel(row)->TryCastAsMessageModel(), node->mutable_folder()->add_children(), snapshot, kept);
+  }
+}
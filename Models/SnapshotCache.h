@@ -0,0 +1,40 @@
+#ifndef SNAPSHOTCACHE_H
+#define SNAPSHOTCACHE_H
+
+#include "Components/ProjectSaver.h"
+#include "MessageModel.h"
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+
+#include <memory>
+
+// Copies of the project's resources as of the last snapshot, each kept until its model reports an edit. Taking a
+// snapshot to save therefore only copies the resources edited since the one before; the rest are shared with it.
+class SnapshotCache : public QObject {
+  Q_OBJECT
+
+ public:
+  explicit SnapshotCache(QObject *parent = nullptr) : QObject(parent) {}
+
+  // Snapshots the project whose resource tree is modeled by `root`. The project itself is left as it was.
+  ProjectSnapshot Take(buffers::Project *project, MessageModel *root);
+  // Forgets every copy; for when a different project is opened.
+  void Clear();
+
+ private:
+  struct Entry {
+    QPointer<MessageModel> model;
+    std::shared_ptr<const buffers::TreeNode> copy;
+    QMetaObject::Connection edited, reset;
+  };
+
+  void Visit(MessageModel *model, buffers::TreeNode *node, ProjectSnapshot *snapshot,
+             QHash<MessageModel *, Entry> *kept);
+  void Forget(MessageModel *model);
+
+  QHash<MessageModel *, Entry> _entries;
+};
+
+#endif  // SNAPSHOTCACHE_H
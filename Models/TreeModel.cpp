@@ -2,7 +2,9 @@
 #include "MainWindow.h"
 
 #include "Components/ArtManager.h"
+#include "Components/ThumbnailService.h"
 #include "Components/Logger.h"
+#include "Models/ChangeJournal.h"
 #include "Models/ResourceModelMap.h"
 
 #include <QCoreApplication>
@@ -10,6 +12,8 @@
 #include <QMimeData>
 #include <QStack>
 
+#include <algorithm>
+
 static QSet<const QModelIndex> GroupNodes(const QSet<const QModelIndex> &nodes) {
   QSet <const QModelIndex> ret;
   for (const auto& n : nodes) {
@@ -31,10 +35,11 @@ TreeModel::TreeModel(MessageModel *root, QObject *parent, const DisplayConfig &c
     : QAbstractItemModel(parent),
       mime_types_(GetMimeTypes(root->GetDescriptor())),
       display_config_(config),
-      root_(std::make_shared<Node>(this, nullptr, -1, root, -1)),
+      root_(new Node(this, nullptr, -1, root, -1)),
       root_model_(root) {
   RebuildModelMapping();
   connect(root, &MessageModel::modelReset, this, &TreeModel::DataBlownAway);
+  connect(ThumbnailService::Instance(), &ThumbnailService::ThumbnailsReady, this, &TreeModel::ThumbnailsReady);
 }
 
 void TreeModel::DataBlownAway() {
@@ -45,6 +50,25 @@ void TreeModel::DataBlownAway() {
   endResetModel();
 }
 
+void TreeModel::ThumbnailsReady(const QSet<QString> &files) {
+  for (const QString &file : files) {
+    // Copied, as a refreshed node may be refiled under another file.
+    const QVector<Node *> nodes = thumbnail_nodes_.value(file);
+    for (Node *node : nodes) node->RefreshThumbnail();
+  }
+}
+
+void TreeModel::RefileThumbnail(Node *node, const QString &from, const QString &to) {
+  if (!from.isEmpty()) {
+    auto it = thumbnail_nodes_.find(from);
+    if (it != thumbnail_nodes_.end()) {
+      it->removeOne(node);
+      if (it->isEmpty()) thumbnail_nodes_.erase(it);
+    }
+  }
+  if (!to.isEmpty()) thumbnail_nodes_[to].append(node);
+}
+
 void TreeModel::RebuildModelMapping() {
   // Drop references to orphans.
   QHash<ProtoModel *, std::shared_ptr<Node>> temp;
@@ -53,7 +77,6 @@ void TreeModel::RebuildModelMapping() {
 }
 
 void TreeModel::Node::AddSelfToMap(const std::shared_ptr<Node> &self) {
-  backing_tree->live_nodes.insert(this);
   if (passthrough_model) {
     backing_tree->backing_nodes_.insert(passthrough_model, self);
     if (passthrough_node) {
@@ -87,7 +110,7 @@ bool TreeModel::setData(const QModelIndex &index, const QVariant &value, int rol
   R_EXPECT(node && node->parent && node->parent->BackingModel(), false);
   RepeatedMessageModel* siblings = node->parent->BackingModel()->TryCastAsRepeatedMessageModel();
   R_EXPECT(siblings, false);
-  MessageModel* model = siblings->GetSubModel(node->row_in_parent)->TryCastAsMessageModel();
+  MessageModel* model = siblings->GetSubModel(node->Row())->TryCastAsMessageModel();
   QString oldName = model->Data(FieldPath::Of<buffers::TreeNode>(buffers::TreeNode::kNameFieldNumber)).toString();
   buffers::TreeNode::TypeCase type = (buffers::TreeNode::TypeCase)model->OneOfType("type");
   if (value.toString() == oldName) return false;
@@ -232,10 +255,10 @@ QModelIndex TreeModel::parent(const QModelIndex &index) const {
   R_EXPECT(node, QModelIndex()) << "Getting parent of bad index " << index << "...";
   Node *const parent = node->parent;
   if (!parent || !parent->parent) return {};
-  return parent->parent->index(parent->row_in_parent);
+  return parent->parent->index(parent->Row());
 }
 
-QModelIndex TreeModel::Node::index(int row) const { return backing_tree->createIndex(row, 0, (void *)this); }
+QModelIndex TreeModel::Node::index(int row) const { return backing_tree->createIndex(row, 0, PackNodeId(node_handle)); }
 QString TreeModel::Node::DebugPath() const {
   if (backing_tree->IsValidNode(parent))
     return parent->DebugPath() + " → " + display_name;
@@ -243,19 +266,71 @@ QString TreeModel::Node::DebugPath() const {
 }
 
 TreeModel::Node *TreeModel::IndexToNode(const QModelIndex &index) const {
-  if (index.isValid() && index.internalPointer()) {
-    Node *parent = static_cast<Node *>(index.internalPointer());
-    R_EXPECT(IsValidNode(parent), nullptr) << "Dangling internal pointer to tree Node: " << parent;
+  if (index.isValid() && index.internalId()) {
+    Node *parent = LookupNode(index.internalId());
+    R_EXPECT(parent, nullptr) << "Dangling internal id to tree Node: " << index.internalId();
     Node *node = parent->NthChild(index.row());
     if (!node) return nullptr;
-    R_EXPECT(root_model_->ValidateSubModel(node->BackingModel()), nullptr)
+#ifdef RGM_DEBUG
+    R_EXPECT(IsValidNode(node), nullptr) << "Tree Node " << parent->DebugPath() << " has a dangling child: " << node;
+    R_EXPECT(root_model_->ValidateSubModel(node->BackingHandle()), nullptr)
         << "Tree contains a node (" << node->DebugPath() << ") with a dead model attached.";
+#endif
     return node;
   } else {
     return root_.get();
   }
 }
 
+// The low bits of an internal id hold the slot index, the high bits its generation. With a 64-bit quintptr each gets
+// 32 bits. A 32-bit quintptr is split 20/12, which limits the table to about a million nodes; generations then wrap
+// after 4095 reuses of a slot, and an index kept across that many is taken for the newer node. Generations start at 1
+// and skip 0 when they wrap, so a valid id is never zero.
+static constexpr int kNodeIndexBits = sizeof(quintptr) >= 8 ? 32 : 20;
+static constexpr int kNodeGenerationBits = sizeof(quintptr) >= 8 ? 32 : sizeof(quintptr) * 8 - kNodeIndexBits;
+static constexpr quintptr kNodeIndexMask = (quintptr(1) << kNodeIndexBits) - 1;
+static constexpr quint32 kMaxNodeGeneration = quint32((quint64(1) << kNodeGenerationBits) - 1);
+
+quintptr TreeModel::PackNodeId(ModelHandle handle) {
+  return (quintptr(handle.generation) << kNodeIndexBits) | (handle.index & kNodeIndexMask);
+}
+
+TreeModel::Node *TreeModel::LookupNode(quintptr id) const {
+  const quintptr index = id & kNodeIndexMask;
+  if (index >= node_table_.size()) return nullptr;
+  const NodeSlot &slot = node_table_[index];
+  return PackNodeId({quint32(index), slot.generation}) == id ? slot.node : nullptr;
+}
+
+ModelHandle TreeModel::RegisterNode(Node *node) {
+  quint32 index;
+  if (!free_node_slots_.empty()) {
+    index = free_node_slots_.back();
+    free_node_slots_.pop_back();
+  } else {
+    R_EXPECT(node_table_.size() <= kNodeIndexMask, ModelHandle()) << "Tree node table is full";
+    index = node_table_.size();
+    node_table_.emplace_back();
+  }
+  node_table_[index].node = node;
+#ifdef RGM_DEBUG
+  live_nodes.insert(node);
+#endif
+  return {index, node_table_[index].generation};
+}
+
+void TreeModel::UnregisterNode(ModelHandle handle) {
+  R_EXPECT_V(handle.index < node_table_.size() && node_table_[handle.index].generation == handle.generation)
+      << "Tree Node unregistered twice";
+  NodeSlot &slot = node_table_[handle.index];
+#ifdef RGM_DEBUG
+  live_nodes.erase(slot.node);
+#endif
+  slot.node = nullptr;
+  if (slot.generation++ == kMaxNodeGeneration) slot.generation = 1;
+  free_node_slots_.push_back(handle.index);
+}
+
 static void CollectNodes(const QModelIndex &node, QSet<const QModelIndex> &cache) {
   auto model = node.model();
 
@@ -266,6 +341,10 @@ static void CollectNodes(const QModelIndex &node, QSet<const QModelIndex> &cache
 }
 
 void TreeModel::BatchRemove(const QSet<const QModelIndex> &indexes) {
+  // One ancestor notification for the whole removal, no matter how many rows go.
+  ProtoModel::ChangeBatch batch;
+  // Rows removed from open editors' resources aren't theirs to undo; declared first so it outlives the removers.
+  ChangeJournal::ExternalEdit external;
   std::map<ProtoModel*, RepeatedMessageModel::RowRemovalOperation> removers;
   QVector<QPair<TreeNode::TypeCase, QString>> deletedResources;
 
@@ -305,12 +384,8 @@ void TreeModel::BatchRemove(const QSet<const QModelIndex> &indexes) {
     }
 
     R_ASSESS_C(remove_from);
-    //TODO: Calling redundantly so delete/dnd last child of group doesn't spam warnings
-    //RowRemovalOperation resets model which for some reason doesn't fix it, but this does
-    //Calling begin/end remove fixes both cases
-    beginRemoveRows(index.parent(), index.row(), index.row());
+    // The tree hears about the removal from remove_from once the removers run, and splices the node out then.
     removers.emplace(remove_from, remove_from).first->second.RemoveRow(remove_me->RowInParent());
-    endRemoveRows();
   }
 
   for (auto& res : deletedResources)
@@ -331,6 +406,7 @@ static bool Describes(const FieldPath &field_path, int field_number) {
 TreeModel::Node::Node(TreeModel *backing_tree, Node *parent, int row_in_parent, MessageModel *model, int row_in_model)
     : backing_tree(backing_tree),
       parent(parent),
+      node_handle(backing_tree->RegisterNode(this)),
       backing_model(model),
       row_in_parent(row_in_parent),
       row_in_model(row_in_model) {
@@ -340,10 +416,10 @@ TreeModel::Node::Node(TreeModel *backing_tree, Node *parent, int row_in_parent,
 void TreeModel::Node::RegisterDataListener() {
   updaters.push_back(connect(backing_model, &PrimitiveModel::dataChanged, [this]{
     if (!parent) backing_tree->beginResetModel();
-    RebuildFromAnyModel(backing_model, parent, row_in_parent);
+    RebuildFromAnyModel(backing_model, parent, Row());
     UpdateParents();
     if (parent) {
-      const QModelIndex ind = parent->index(row_in_parent);
+      const QModelIndex ind = TreeIndex();
       emit backing_tree->dataChanged(ind, ind);
     } else {
       backing_tree->endResetModel();
@@ -352,30 +428,110 @@ void TreeModel::Node::RegisterDataListener() {
 }
 
 void TreeModel::Node::RegisterRowListeners() {
-  auto update = [this]{
-    QModelIndex ind;
-    if (parent) {
-      ind = parent->index(row_in_parent);
-      emit backing_tree->layoutAboutToBeChanged({ind});
-    } else {
-      backing_tree->beginResetModel();
-    }
-    RecursiveUndoPassThrough();
-    this->RebuildFromAnyModel(backing_model, parent, row_in_parent);
-    if (parent) {
-      this->UpdateParents();
-      emit backing_tree->dataChanged(ind, ind);
-      emit backing_tree->layoutChanged({ind});
-    } else {
-      backing_tree->RebuildModelMapping();
-      backing_tree->endResetModel();
-    }
-    AddSelfToMap(passthrough_node);
-  };
-  updaters.push_back(connect(backing_model, &ProtoModel::rowsInserted, update));
-  updaters.push_back(connect(backing_model, &ProtoModel::modelReset, update));
-  updaters.push_back(connect(backing_model, &ProtoModel::rowsRemoved, update));
-  updaters.push_back(connect(backing_model, &ProtoModel::rowsMoved, update));
+  updaters.push_back(connect(backing_model, &ProtoModel::rowsInserted,
+                             [this](const QModelIndex &, int first, int last) { InsertChildren(first, last); }));
+  updaters.push_back(connect(backing_model, &ProtoModel::rowsRemoved,
+                             [this](const QModelIndex &, int first, int last) { RemoveChildren(first, last); }));
+  updaters.push_back(connect(backing_model, &ProtoModel::rowsMoved,
+                             [this](const QModelIndex &, int first, int last, const QModelIndex &, int destination) {
+                               MoveChildren(first, last, destination);
+                             }));
+  updaters.push_back(connect(backing_model, &ProtoModel::modelReset, [this]() { RebuildAll(); }));
+}
+
+void TreeModel::Node::RebuildAll() {
+  QModelIndex ind;
+  if (parent) {
+    ind = TreeIndex();
+    emit backing_tree->layoutAboutToBeChanged({ind});
+  } else {
+    backing_tree->beginResetModel();
+  }
+  RecursiveUndoPassThrough();
+  this->RebuildFromAnyModel(backing_model, parent, Row());
+  if (parent) {
+    this->UpdateParents();
+    emit backing_tree->dataChanged(ind, ind);
+    emit backing_tree->layoutChanged({ind});
+  } else {
+    backing_tree->RebuildModelMapping();
+    backing_tree->endResetModel();
+  }
+  AddSelfToMap(passthrough_node);
+}
+
+void TreeModel::Node::InsertChildren(int first, int last) {
+  auto *const repeated_model = backing_model->TryCastAsRepeatedModel();
+  const int count = last - first + 1;
+  if (!repeated_model || first < 0 || first > int(children.size()) ||
+      int(children.size()) + count != repeated_model->rowCount()) {
+    return RebuildAll();
+  }
+
+  std::vector<std::shared_ptr<Node>> added;
+  added.reserve(count);
+  for (int row = first; row <= last; ++row) {
+    std::shared_ptr<Node> child = MakeChild(repeated_model->GetSubModel(row), row, row);
+    if (!child) return RebuildAll();
+    added.push_back(child);
+  }
+
+  backing_tree->beginInsertRows(TreeIndex(), first, last);
+  children.insert(children.begin() + first, added.begin(), added.end());
+  stale_rows_from = std::min(stale_rows_from, last + 1);
+  for (const auto &child : added) child->AddSelfToMap(child);
+  backing_tree->endInsertRows();
+  UpdateParents();
+}
+
+void TreeModel::Node::RemoveChildren(int first, int last) {
+  const int count = last - first + 1;
+  if (!backing_model->TryCastAsRepeatedModel() || first < 0 || last >= int(children.size()) ||
+      int(children.size()) - count != backing_model->rowCount()) {
+    return RebuildAll();
+  }
+
+  backing_tree->beginRemoveRows(TreeIndex(), first, last);
+  for (int row = first; row <= last; ++row) children[row]->RemoveSelfFromMap();
+  children.erase(children.begin() + first, children.begin() + last + 1);
+  stale_rows_from = std::min(stale_rows_from, first);
+  backing_tree->endRemoveRows();
+  UpdateParents();
+}
+
+void TreeModel::Node::MoveChildren(int first, int last, int destination) {
+  if (destination >= first && destination <= last + 1) return;  // Nothing actually moves.
+  if (!backing_model->TryCastAsRepeatedModel() || first < 0 || last >= int(children.size()) || destination < 0 ||
+      destination > int(children.size())) {
+    return RebuildAll();
+  }
+
+  const QModelIndex ind = TreeIndex();
+  if (!backing_tree->beginMoveRows(ind, first, last, ind, destination)) return RebuildAll();
+  if (destination < first) {
+    std::rotate(children.begin() + destination, children.begin() + first, children.begin() + last + 1);
+  } else {
+    std::rotate(children.begin() + first, children.begin() + last + 1, children.begin() + destination);
+  }
+  stale_rows_from = std::min(stale_rows_from, std::min(first, destination));
+  backing_tree->endMoveRows();
+}
+
+void TreeModel::Node::RenumberChildren() {
+  // Only children of repeated nodes are ever spliced, and those map 1:1 onto the rows of the model.
+  for (int row = stale_rows_from; row < int(children.size()); ++row) {
+    children[row]->row_in_parent = children[row]->row_in_model = row;
+  }
+  stale_rows_from = std::numeric_limits<int>::max();
+}
+
+void TreeModel::Node::RemoveSelfFromMap() {
+  auto &nodes = backing_tree->backing_nodes_;
+  for (ProtoModel *model : {backing_model, passthrough_model}) {
+    if (auto it = nodes.find(model); it != nodes.end() && it->get() == this) nodes.erase(it);
+  }
+  if (passthrough_node) passthrough_node->RemoveSelfFromMap();
+  for (const auto &child : children) child->RemoveSelfFromMap();
 }
 
 
@@ -417,6 +573,7 @@ TreeModel::Node::Node(TreeModel *backing_tree, Node *parent, int row_in_parent,
                       int row_in_model)
     : backing_tree(backing_tree),
       parent(parent),
+      node_handle(backing_tree->RegisterNode(this)),
       backing_model(model),
       row_in_parent(row_in_parent),
       row_in_model(row_in_model) {
@@ -436,6 +593,7 @@ void TreeModel::Node::RebuildFromModel(RepeatedMessageModel *model, Node *parent
 TreeModel::Node::Node(TreeModel *backing_tree, Node *parent, int row_in_parent, RepeatedModel *model, int row_in_model)
     : backing_tree(backing_tree),
       parent(parent),
+      node_handle(backing_tree->RegisterNode(this)),
       backing_model(model),
       row_in_parent(row_in_parent),
       row_in_model(row_in_model) {
@@ -454,6 +612,7 @@ void TreeModel::Node::RebuildFromModel(RepeatedModel *model, Node *parent, int r
 TreeModel::Node::Node(TreeModel *backing_tree, Node *parent, int row_in_parent, PrimitiveModel *model, int row_in_model)
     : backing_tree(backing_tree),
       parent(parent),
+      node_handle(backing_tree->RegisterNode(this)),
       backing_model(model),
       row_in_parent(row_in_parent),
       row_in_model(row_in_model) {
@@ -468,6 +627,7 @@ void TreeModel::Node::Reset(ProtoModel *model, Node *parent, int row_in_parent)
   UndoPassThrough();
   ClearListeners();
   children.clear();
+  stale_rows_from = std::numeric_limits<int>::max();
   if (parent == this || (parent && parent->parent == this)) {
     qDebug() << "SEVERE: Cyclical parents: " << DebugPath() << " is being assigned " << parent->DebugPath();
   } else {
@@ -475,6 +635,7 @@ void TreeModel::Node::Reset(ProtoModel *model, Node *parent, int row_in_parent)
     this->row_in_parent = row_in_parent;
   }
   backing_model = model;
+  backing_handle = model->GetHandle();
   is_passthrough = false;
   ComputeDisplayData();
 }
@@ -484,7 +645,11 @@ void TreeModel::Node::DataChanged() {
 }
 
 void TreeModel::Node::PushChild(ProtoModel *model, int source_row) {
-  R_EXPECT_V(model) << "Null model passed to TreeNode::PushChild()...";
+  if (std::shared_ptr<Node> node = MakeChild(model, source_row, children.size())) children.push_back(node);
+}
+
+std::shared_ptr<TreeModel::Node> TreeModel::Node::MakeChild(ProtoModel *model, int source_row, int row) {
+  R_EXPECT(model, nullptr) << "Null model passed to TreeNode::MakeChild()...";
   std::shared_ptr<Node> node;
   if (auto it = backing_tree->backing_nodes_.find(model); it != backing_tree->backing_nodes_.end()) {
     node = *it;
@@ -495,29 +660,29 @@ void TreeModel::Node::PushChild(ProtoModel *model, int source_row) {
   }
   if (auto *sub_message = model->TryCastAsMessageModel()) {
     if (node)
-      node->RebuildFromModel(sub_message, this, children.size());
+      node->RebuildFromModel(sub_message, this, row);
     else
-      node = std::make_unique<Node>(backing_tree, this, children.size(), sub_message, source_row);
+      node = std::make_unique<Node>(backing_tree, this, row, sub_message, source_row);
   } else if (auto *repeated_message = model->TryCastAsRepeatedMessageModel()) {
     if (node)
-      node->RebuildFromModel(repeated_message, this, children.size());
+      node->RebuildFromModel(repeated_message, this, row);
     else
-      node = std::make_unique<Node>(backing_tree, this, children.size(), repeated_message, source_row);
+      node = std::make_unique<Node>(backing_tree, this, row, repeated_message, source_row);
   } else if (auto *repeated_message = model->TryCastAsRepeatedModel()) {
     if (node)
-      node->RebuildFromModel(repeated_message, this, children.size());
+      node->RebuildFromModel(repeated_message, this, row);
     else
-      node = std::make_unique<Node>(backing_tree, this, children.size(), repeated_message, source_row);
+      node = std::make_unique<Node>(backing_tree, this, row, repeated_message, source_row);
   } else if (auto *primitive_message = model->TryCastAsPrimitiveModel()) {
     if (node)
-      node->RebuildFromModel(primitive_message, this, children.size());
+      node->RebuildFromModel(primitive_message, this, row);
     else
-      node = std::make_unique<Node>(backing_tree, this, children.size(), primitive_message, source_row);
+      node = std::make_unique<Node>(backing_tree, this, row, primitive_message, source_row);
   } else {
     qDebug() << "Node has unknown type...";
-    return;
+    return nullptr;
   }
-  children.push_back(node);
+  return node;
 }
 
 void TreeModel::Node::Print(int indent) const {
@@ -527,8 +692,8 @@ void TreeModel::Node::Print(int indent) const {
 }
 
 TreeModel::Node::~Node() {
-  if (auto it = backing_tree->live_nodes.find(this); it != backing_tree->live_nodes.end())
-    backing_tree->live_nodes.erase(it);
+  backing_tree->UnregisterNode(node_handle);
+  backing_tree->RefileThumbnail(this, icon_file, QString());
   ClearListeners();
 }
 
@@ -549,7 +714,10 @@ void TreeModel::Node::PassThrough() {
   passthrough_node->row_in_parent = row_in_parent;
   passthrough_model = backing_model;
   backing_model = passthrough_node->backing_model;
-  children = passthrough_node->children;
+  backing_handle = passthrough_node->backing_handle;
+  // Take the children over outright so that splices made while passed through can't leave a stale copy behind.
+  children = std::move(passthrough_node->children);
+  passthrough_node->children.clear();
   for (auto &child : children) {
     if (parent == child.get()) {
       qDebug() << "CRITICAL: Node parent loop. Disconnecting loop. Something bad will happen.";
@@ -564,6 +732,7 @@ void TreeModel::Node::PassThrough() {
 void TreeModel::Node::UndoPassThrough() {
   if (!passthrough_node) return;
   ClearListeners();
+  RenumberChildren();
   for (auto &child : children) {
     if (passthrough_node->parent == child.get()) {
       qDebug() << "CRITICAL: Node parent loop. Disconnecting loop. Something bad will happen.";
@@ -571,6 +740,7 @@ void TreeModel::Node::UndoPassThrough() {
       child->parent = passthrough_node.get();
     }
   }
+  passthrough_node->children = std::move(children);
   children.clear();
   children.push_back(passthrough_node);
   passthrough_node->parent = this;
@@ -579,6 +749,7 @@ void TreeModel::Node::UndoPassThrough() {
   passthrough_node.reset();
 
   backing_model = passthrough_model;
+  backing_handle = passthrough_model->GetHandle();
   passthrough_model = nullptr;
   RegisterRowListeners();
 }
@@ -624,7 +795,7 @@ QModelIndex TreeModel::mapFromSource(const QModelIndex &source_index) const {
 QModelIndex TreeModel::mapToSource(const QModelIndex &proxyIndex) const {
   if (!proxyIndex.isValid()) return {};
   if (Node *n = IndexToNode(proxyIndex)) {
-    if (n->parent) return n->parent->index(n->row_in_parent);
+    if (n->parent) return n->parent->index(n->Row());
   }
   return {};
 }
@@ -646,6 +817,16 @@ TreeNode TreeModel::Node::GetMessage() const {
   return *buffer;
 }
 
+const TreeNode *TreeModel::Node::MessageView() const {
+  auto *const message_model = GetMessageModel();
+  return message_model ? message_model->ReadView<TreeNode>() : nullptr;
+}
+
+MessageModel *TreeModel::Node::GetMessageModel() const {
+  auto *const model = passthrough_model ? passthrough_model : backing_model;
+  return model->TryCastAsMessageModel();
+}
+
 TreeModel::Node *TreeModel::Node::NthChild(int n) const {
   R_EXPECT(n >= 0 && (size_t)n < children.size(), nullptr)
       << "Accessing row " << n << " of a " << children.size() << "-row tree node `" << DebugPath() << "`";
@@ -678,6 +859,21 @@ void TreeModel::Node::ComputeDisplayData() {
     if (display_icon.isNull()) display_icon = passthrough_node->display_icon;
     if (display_name.isEmpty()) display_name = passthrough_node->display_name;
   }
+  icon_pending = ThumbnailService::IsPlaceholder(display_icon);
+  const QString file = ThumbnailService::FileOf(display_icon);
+  if (file != icon_file) {
+    backing_tree->RefileThumbnail(this, icon_file, file);
+    icon_file = file;
+  }
+}
+
+void TreeModel::Node::RefreshThumbnail() {
+  if (!parent) return;
+  ComputeDisplayData();
+  if (!icon_pending) {
+    const QModelIndex ind = TreeIndex();
+    emit backing_tree->dataChanged(ind, ind, {Qt::DecorationRole});
+  }
 }
 
 
@@ -718,7 +914,7 @@ QModelIndex TreeModel::duplicateNode(const QModelIndex & index) {
     //return node->mapFromSource(node->repeated_model->duplicate(mapToSource(index)));
   }
   Node *parent = IndexToNode(index.parent());
-  return node->duplicate(parent, node->row_in_parent+1);
+  return node->duplicate(parent, node->Row() + 1);
 }
 
 void TreeModel::sortByName(const QModelIndex & index) {
@@ -729,7 +925,7 @@ void TreeModel::sortByName(const QModelIndex & index) {
 
 void TreeModel::triggerNodeEdit(const QModelIndex &index, QAbstractItemView *view) {
   R_EXPECT_V(index.isValid()) << "Invalid edit node selected";
-  R_EXPECT_V(index.internalPointer()) << "Junk edit node selected";
+  R_EXPECT_V(index.internalId()) << "Junk edit node selected";
   Node *node = IndexToNode(index);
   if (node) {
     const auto &meta = GetTreeDisplay(GetMessageType(node));
@@ -13,6 +13,7 @@
 #include <QHash>
 #include <QVector>
 
+#include <limits>
 #include <memory>
 #include <unordered_map>
 
@@ -47,7 +48,11 @@ class TreeModel : public QAbstractItemModel {
     Node *parent = nullptr;
 
    private:
+    /// This node's slot in the containing tree's node table; packed into the internalId of indexes of its children.
+    const ModelHandle node_handle;
     ProtoModel *backing_model;
+    /// Liveness handle of backing_model, used to catch nodes which outlived their model.
+    ModelHandle backing_handle;
     /// For nodes whose child was a single passthrough node with a single child,
     /// this is the intermediate node that is not displayed.
     std::shared_ptr<Node> passthrough_node;
@@ -63,8 +68,14 @@ class TreeModel : public QAbstractItemModel {
     QString display_name;
     /// Cache of the icon field or per-message display icon of the underlying proto.
     QIcon display_icon;
+    /// Whether display_icon is a placeholder for a thumbnail which is still being decoded.
+    bool icon_pending = false;
+    /// The file display_icon is (or is waiting on) a thumbnail of, if any. The node is filed under it in the tree's
+    /// thumbnail_nodes_, so it is refreshed when that thumbnail is ready or rebuilt.
+    QString icon_file;
     /// Generally a cache of this node's position in its parent Node's list of children (parent->children).
     /// This may not correspond 1:1 with the field mapping in the model. Use `row_in_model` for that.
+    /// May be stale after rows are spliced into or out of the parent; read it through Row().
     int row_in_parent = 0;
     /// The row number of this node's data in its model (i.e. parent->backing_model).
     /// This may not correspond 1:1 with the node's position in its parent. Use `row_in_parent` for that.
@@ -76,9 +87,18 @@ class TreeModel : public QAbstractItemModel {
     std::vector<std::shared_ptr<Node>> children;
 
     bool SetName(const QString &name, const ProtoModel::MessageDisplayConfig &meta);
+    /// This node's position in its parent, renumbering its siblings first if a splice left them stale.
+    int Row() {
+      if (parent) parent->RenumberChildren();
+      return row_in_parent;
+    }
     Node *NthChild(int n) const;
     const std::string &GetMessageType() const;
     TreeNode GetMessage() const;
+    /// The TreeNode this node displays, without copying it. Null if this node does not represent a TreeNode message.
+    const TreeNode *MessageView() const;
+    /// The message model this node displays (for passed-through nodes, the outermost one). Null for other nodes.
+    MessageModel *GetMessageModel() const;
     QModelIndex mapFromSource(const QModelIndex &index) const;
     void sort();
     QModelIndex index(int row) const;
@@ -91,6 +111,7 @@ class TreeModel : public QAbstractItemModel {
     /// Returns whether this node represents a repeated field.
     bool IsRepeated() const;
     ProtoModel *BackingModel() const;
+    ModelHandle BackingHandle() const { return backing_handle; }
 
     /// Debug print.
     void Print(int indent = 0) const;
@@ -103,9 +124,13 @@ class TreeModel : public QAbstractItemModel {
     Node(TreeModel *backing_tree, Node *parent, int row_in_parent, RepeatedMessageModel *model, int row_in_model);
     /// Constructs as a leaf node. The specified field should not be a message.
     Node(TreeModel *backing_tree, Node *parent, int row_in_parent, PrimitiveModel *model_row, int row_in_model);
-    /// Removes self from the live set.
+    /// Removes self from the node table.
     ~Node();
 
+    /// Nodes share their project's model arena.
+    static void *operator new(std::size_t size) { return ModelArena::Allocate(size); }
+    static void operator delete(void *ptr) { ModelArena::Free(ptr); }
+
     void RebuildFromModel(MessageModel *model, Node *parent, int row_in_parent);
     void RebuildFromModel(RepeatedModel *model, Node *parent, int row_in_parent);
     void RebuildFromModel(RepeatedMessageModel *model, Node *parent, int row_in_parent);
@@ -125,8 +150,14 @@ class TreeModel : public QAbstractItemModel {
     void RecursiveUndoPassThrough();
 
     void DataChanged();
+    /// Recomputes the display data of this node after the thumbnail of its icon_file became ready.
+    void RefreshThumbnail();
 
    private:
+    /// Children from this index onward have stale row numbers; see RenumberChildren().
+    int stale_rows_from = std::numeric_limits<int>::max();
+
+    std::shared_ptr<Node> MakeChild(ProtoModel *model, int source_row, int row);
     void PushChild(ProtoModel *model, int source_row);
     void ComputeDisplayData();
     void Reset(ProtoModel *model, Node *parent, int row_in_parent);
@@ -137,8 +168,21 @@ class TreeModel : public QAbstractItemModel {
     void ClearListeners();
     /// Listens for data change events to the given model and rebuilds.
     void RegisterDataListener();
-    /// Listens for row insert/move/delete operations on the given model and rebuilds.
+    /// Listens for row insert/move/delete operations on the given model and splices children to match.
     void RegisterRowListeners();
+    /// Rebuilds this node and everything under it from its model. Used when the model is reset.
+    void RebuildAll();
+    /// Splices children in, out, or around to mirror the same operation on a repeated backing model.
+    /// Each falls back to RebuildAll() if the children don't line up with the model's rows.
+    void InsertChildren(int first, int last);
+    void RemoveChildren(int first, int last);
+    void MoveChildren(int first, int last, int destination);
+    /// Brings row_in_parent and row_in_model of children up to date after a splice.
+    void RenumberChildren();
+    /// Drops this node and its descendants from the containing tree's model map.
+    void RemoveSelfFromMap();
+    /// Index of this node in the containing tree (the parent index of its children).
+    QModelIndex TreeIndex() { return parent ? parent->index(Row()) : QModelIndex(); }
   };
 
   enum UserRoles {
@@ -232,12 +276,21 @@ class TreeModel : public QAbstractItemModel {
 
   Node *IndexToNode(const QModelIndex &index) const;
   Node *ValidateNode(Node *node) const { return IsValidNode(node) ? node : nullptr; }
-  bool IsValidNode(Node *node) const { return live_nodes.find(node) != live_nodes.end(); }
+  /// Checks a raw Node pointer against the set of living nodes. Release builds don't track that set, and only check
+  /// for null; indexes are validated through the node table in either case.
+  bool IsValidNode(Node *node) const {
+#ifdef RGM_DEBUG
+    return live_nodes.find(node) != live_nodes.end();
+#else
+    return node != nullptr;
+#endif
+  }
   void BatchRemove(const QSet<const QModelIndex> &indexes);
 
   // Slots
  public slots:
   void DataBlownAway();
+  void ThumbnailsReady(const QSet<QString> &files);
 
  signals:
   void TreeChanged(MessageModel* root);
@@ -251,8 +304,28 @@ class TreeModel : public QAbstractItemModel {
   void ModelAboutToBeDeleted(MessageModel *m);
 
  private:
+  struct NodeSlot {
+    Node *node = nullptr;
+    quint32 generation = 1;
+  };
+  /// Flat table of all living nodes belonging to this tree. The internalId of each index packs the slot and generation
+  /// of its parent node, so resolving an index is an array lookup and a compare.
+  std::vector<NodeSlot> node_table_;
+  std::vector<quint32> free_node_slots_;
+#ifdef RGM_DEBUG
   /// Set of all living nodes belonging to this tree.
   std::set<Node*> live_nodes;
+#endif
+
+  ModelHandle RegisterNode(Node *node);
+  void UnregisterNode(ModelHandle handle);
+  Node *LookupNode(quintptr id) const;
+  static quintptr PackNodeId(ModelHandle handle);
+  /// Moves a node from one file's entry in thumbnail_nodes_ to another's. Either file may be empty.
+  void RefileThumbnail(Node *node, const QString &from, const QString &to);
+  /// Nodes by the file their icon is a thumbnail of (see Node::icon_file). Declared ahead of anything holding nodes,
+  /// which unfile themselves as they are destroyed.
+  QHash<QString, QVector<Node*>> thumbnail_nodes_;
   /// Map from backing model to the node representing it.
   QHash<ProtoModel*, std::shared_ptr<Node>> backing_nodes_;
 
@@ -1,5 +1,6 @@
 #include "TreeSortFilterProxyModel.h"
 #include "ProtoModel.h"
+#include "TreeModel.h"
 
 TreeSortFilterProxyModel::TreeSortFilterProxyModel(QObject *parent) : QSortFilterProxyModel(parent) {}
 
@@ -8,9 +9,9 @@ void TreeSortFilterProxyModel::SetFilterType(TreeNode::TypeCase type) {
   filterType = type;
 }
 
-inline bool recHasType(TreeNode& n, TreeNode::TypeCase type) {
+inline bool recHasType(const TreeNode& n, TreeNode::TypeCase type) {
   if (!n.has_folder()) return false;
-  for (auto child : n.folder().children()) {
+  for (const auto& child : n.folder().children()) {
     if (child.type_case() == TreeNode::kFolder) return recHasType(child, type);
     if (child.type_case() == type) return true;
   }
@@ -21,8 +22,12 @@ bool TreeSortFilterProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex
 
   if (filterType == TreeNode::TYPE_NOT_SET) return true;
 
-  QModelIndex idx = sourceModel()->index(sourceRow, 0, sourceParent);
-  buffers::TreeNode *item = static_cast<buffers::TreeNode *>(idx.internalPointer());
+  // Tree indexes don't point at their data; resolve the node and read its message in place.
+  auto *tree = qobject_cast<TreeModel *>(sourceModel());
+  if (!tree) return true;
+  TreeModel::Node *node = tree->IndexToNode(tree->index(sourceRow, 0, sourceParent));
+  const buffers::TreeNode *item = node ? node->MessageView() : nullptr;
+  if (!item) return false;
 
   if (item->has_folder() && item->folder().children_size() > 0) {
     return recHasType(*item, filterType);
@@ -73,11 +73,15 @@ SOURCES += \
     Models/EventTypesListSortFilterProxyModel.cpp \
     Models/EventsListModel.cpp \
     Models/MessageModel.cpp \
+    Models/ModelArena.cpp \
+    Models/ChangeJournal.cpp \
+    Models/SnapshotCache.cpp \
     Models/PrimitiveModel.cpp \
     Models/RepeatedMessageModel.cpp \
     Models/RepeatedModel.cpp \
     Models/RepeatedSortFilterProxyModel.cpp \
     Utils/FieldPath.cpp \
+    Utils/ImageKernels.cpp \
     Utils/ProtoManip.cpp \
     Widgets/AssetScrollAreaBackground.cpp \
     Widgets/PathView.cpp \
@@ -103,6 +107,11 @@ SOURCES += \
     Widgets/RoomView.cpp \
     Models/TreeModel.cpp \
     Components/ArtManager.cpp \
+    Components/ImageCache.cpp \
+    Components/ProjectLoader.cpp \
+    Components/ProjectSaver.cpp \
+    Components/ThumbnailService.cpp \
+    Components/ThumbnailStore.cpp \
     Models/ProtoModel.cpp \
     Models/ImmediateMapper.cpp \
     Components/Utility.cpp \
@@ -137,15 +146,21 @@ HEADERS += \
     Models/EventTypesListSortFilterProxyModel.h \
     Models/EventsListModel.h \
     Models/MessageModel.h \
+    Models/ModelArena.h \
+    Models/ChangeJournal.h \
+    Models/SnapshotCache.h \
     Models/PrimitiveModel.h \
     Models/RepeatedMessageModel.h \
     Models/RepeatedModel.h \
     Models/RepeatedPrimitiveModel.h \
     Models/RepeatedSortFilterProxyModel.h \
     Utils/FieldPath.h \
+    Utils/ImageKernels.h \
     Utils/ProtoManip.h \
     Utils/QBoilerplate.h \
     Utils/SafeCasts.h \
+    Utils/RenderList.h \
+    Utils/SpatialGrid.h \
     Widgets/AssetScrollArea.h \
     Widgets/AssetScrollAreaBackground.h \
     Widgets/BackgroundView.h \
@@ -158,6 +173,11 @@ HEADERS += \
     Models/TreeModel.h \
     Components/Logger.h \
     Components/ArtManager.h \
+    Components/ImageCache.h \
+    Components/ProjectLoader.h \
+    Components/ProjectSaver.h \
+    Components/ThumbnailService.h \
+    Components/ThumbnailStore.h \
     Models/ProtoModel.h \
     Models/ImmediateMapper.h \
     Components/Utility.h \
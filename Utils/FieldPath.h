@@ -4,6 +4,7 @@
 #include <QDebug>
 #include <QString>
 #include <google/protobuf/descriptor.h>
+#include <array>
 #include <vector>
 
 class FieldPath {
@@ -102,6 +103,44 @@ class FieldPath {
   FieldPath operator+(const FieldPath &field_path) const;
 
   explicit operator bool() const { return fields.size(); }
+
+  /// Non-owning, allocation-free form of a field path whose descriptors were resolved ahead of time.
+  /// Only a leading repeated index (as with StartingAt()) is supported. Produced by Static, below.
+  struct Resolved {
+    const FieldDescriptor *const *fields;
+    int size;
+    int repeated_field_index = -1;
+  };
+
+  /// Field path whose descriptors are looked up once per instantiation instead of on every call, for use in hot
+  /// loops. `FieldPath::Static<Room::Instance, Room::Instance::kXFieldNumber>(row)` refers to the same field as
+  /// `FieldPath::Of<Room::Instance>(FieldPath::StartingAt(row), Room::Instance::kXFieldNumber)`.
+  template<typename T, int... kFields> struct Static : Resolved {
+    explicit Static(int start_index = -1): Resolved{Descriptors().data(), sizeof...(kFields), start_index} {}
+
+    static const std::array<const FieldDescriptor *, sizeof...(kFields)> &Descriptors() {
+      static const std::array<const FieldDescriptor *, sizeof...(kFields)> descriptors = Resolve();
+      return descriptors;
+    }
+
+   private:
+    static std::array<const FieldDescriptor *, sizeof...(kFields)> Resolve() {
+      std::array<const FieldDescriptor *, sizeof...(kFields)> res{};
+      const Descriptor *md = T::GetDescriptor();
+      size_t i = 0;
+      for (int field_number : {kFields...}) {
+        const FieldDescriptor *fd = md ? md->FindFieldByNumber(field_number) : nullptr;
+        if (!fd) {
+          qDebug() << "Could not locate field " << field_number << " in message "
+                   << (md ? md->full_name().c_str() : "<none>") << "!";
+          break;
+        }
+        res[i++] = fd;
+        md = fd->message_type();
+      }
+      return res;
+    }
+  };
 };
 
 #endif // FIELDPATH_H
@@ -0,0 +1,118 @@
+#include "ImageKernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RGM_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace {
+
+void KeyOutRow(QRgb *row, int width, QRgb key) {
+  int x = 0;
+#ifdef __AVX2__
+  const __m256i key8 = _mm256_set1_epi32(int(key));
+  for (; x + 8 <= width; x += 8) {
+    __m256i *pixels = reinterpret_cast<__m256i *>(row + x);
+    const __m256i values = _mm256_loadu_si256(pixels);
+    _mm256_storeu_si256(pixels, _mm256_andnot_si256(_mm256_cmpeq_epi32(values, key8), values));
+  }
+#endif
+#ifdef RGM_SSE2
+  const __m128i key4 = _mm_set1_epi32(int(key));
+  for (; x + 4 <= width; x += 4) {
+    __m128i *pixels = reinterpret_cast<__m128i *>(row + x);
+    const __m128i values = _mm_loadu_si128(pixels);
+    _mm_storeu_si128(pixels, _mm_andnot_si128(_mm_cmpeq_epi32(values, key4), values));
+  }
+#endif
+  for (; x < width; ++x) {
+    if (row[x] == key) row[x] = 0;
+  }
+}
+
+// Index of the first pixel in [from, to) whose alpha is above the tolerance, or `to` if there is none.
+int FirstOpaque(const QRgb *row, int from, int to, int tolerance) {
+  int x = from;
+  // Skip whole blocks of transparent pixels; the scalar loop below finds the pixel within the block that isn't.
+#ifdef __AVX2__
+  const __m256i limit8 = _mm256_set1_epi32(tolerance);
+  for (; x + 8 <= to; x += 8) {
+    const __m256i alpha = _mm256_srli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + x)), 24);
+    if (_mm256_movemask_epi8(_mm256_cmpgt_epi32(alpha, limit8))) break;
+  }
+#endif
+#ifdef RGM_SSE2
+  const __m128i limit4 = _mm_set1_epi32(tolerance);
+  for (; x + 4 <= to; x += 4) {
+    const __m128i alpha = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x)), 24);
+    if (_mm_movemask_epi8(_mm_cmpgt_epi32(alpha, limit4))) break;
+  }
+#endif
+  for (; x < to; ++x) {
+    if (qAlpha(row[x]) > tolerance) return x;
+  }
+  return to;
+}
+
+// Index of the last pixel in [from, to) whose alpha is above the tolerance, or `from - 1` if there is none.
+int LastOpaque(const QRgb *row, int from, int to, int tolerance) {
+  int x = to;
+#ifdef __AVX2__
+  const __m256i limit8 = _mm256_set1_epi32(tolerance);
+  for (; x - 8 >= from; x -= 8) {
+    const __m256i alpha = _mm256_srli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + x - 8)), 24);
+    if (_mm256_movemask_epi8(_mm256_cmpgt_epi32(alpha, limit8))) break;
+  }
+#endif
+#ifdef RGM_SSE2
+  const __m128i limit4 = _mm_set1_epi32(tolerance);
+  for (; x - 4 >= from; x -= 4) {
+    const __m128i alpha = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x - 4)), 24);
+    if (_mm_movemask_epi8(_mm_cmpgt_epi32(alpha, limit4))) break;
+  }
+#endif
+  while (x > from) {
+    if (qAlpha(row[--x]) > tolerance) return x;
+  }
+  return from - 1;
+}
+
+}  // namespace
+
+void KeyOutColor(QImage *image, QRgb key) {
+  if (image->format() != QImage::Format_ARGB32) *image = image->convertToFormat(QImage::Format_ARGB32);
+  for (int y = 0; y < image->height(); ++y) {
+    KeyOutRow(reinterpret_cast<QRgb *>(image->scanLine(y)), image->width(), key);
+  }
+}
+
+QRect OpaqueBounds(const QImage &image, int alphaTolerance) {
+  if (image.isNull() || alphaTolerance >= 255) return QRect();
+  if (!image.hasAlphaChannel()) return image.rect();
+  QImage argb = image;
+  if (argb.format() != QImage::Format_ARGB32 && argb.format() != QImage::Format_ARGB32_Premultiplied) {
+    argb = argb.convertToFormat(QImage::Format_ARGB32);
+  }
+
+  const int width = argb.width();
+  const int height = argb.height();
+  const auto row = [&argb](int y) { return reinterpret_cast<const QRgb *>(argb.constScanLine(y)); };
+
+  int top = 0;
+  while (top < height && FirstOpaque(row(top), 0, width, alphaTolerance) == width) ++top;
+  if (top == height) return QRect();
+  int bottom = height - 1;
+  while (FirstOpaque(row(bottom), 0, width, alphaTolerance) == width) --bottom;
+
+  // Each row between only needs scanning outside the columns already known to be covered.
+  int left = width;
+  int right = -1;
+  for (int y = top; y <= bottom && (left > 0 || right < width - 1); ++y) {
+    left = FirstOpaque(row(y), 0, left, alphaTolerance);
+    right = LastOpaque(row(y), right + 1, width, alphaTolerance);
+  }
+  return QRect(QPoint(left, top), QPoint(right, bottom));
+}
@@ -0,0 +1,15 @@
+#ifndef IMAGEKERNELS_H
+#define IMAGEKERNELS_H
+
+#include <QImage>
+
+// Passes over every pixel of an image, a scanline at a time, vectorized where the build targets SSE2 or AVX2.
+// They only touch the images given to them, so they are safe to run on any thread.
+
+// Makes every pixel exactly matching the key fully transparent. Converts the image to ARGB32 first if needed.
+void KeyOutColor(QImage *image, QRgb key);
+
+// The smallest rectangle holding every pixel whose alpha is above the tolerance, or a null rect if there are none.
+QRect OpaqueBounds(const QImage &image, int alphaTolerance = 0);
+
+#endif  // IMAGEKERNELS_H
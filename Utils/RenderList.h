@@ -0,0 +1,92 @@
+#ifndef RENDERLIST_H
+#define RENDERLIST_H
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+#include <algorithm>
+#include <map>
+
+// Draw order of items (e.g. the instances of a room): by depth, then by the order they were added in. Items are kept
+// in one bucket per depth, so a change of depth moves the item between buckets instead of resorting everything.
+template <typename T>
+class RenderList {
+ public:
+  int Size() const { return _places.size(); }
+  bool Contains(T item) const { return _places.contains(item); }
+
+  void Clear() {
+    _places.clear();
+    _buckets.clear();
+    _nextSequence = 0;
+  }
+
+  // Adds the item, or moves it if its depth changed. Items keep their place among others of the same depth.
+  void Insert(T item, int depth) {
+    auto it = _places.find(item);
+    if (it != _places.end()) {
+      if (it->depth == depth) return;
+      Unbucket(*it);
+      it->depth = depth;
+    } else {
+      it = _places.insert(item, {depth, _nextSequence++});
+    }
+    _buckets[depth].emplace(it->sequence, item);
+  }
+
+  void Remove(T item) {
+    auto it = _places.find(item);
+    if (it == _places.end()) return;
+    Unbucket(*it);
+    _places.erase(it);
+  }
+
+  // Puts some of the items (e.g. those in view) in draw order. Items not in the list go last.
+  void Sort(QVector<T> *items) const {
+    // Walking the buckets beats sorting once most of the list is asked for.
+    if (items->size() > _places.size() / 2) {
+      QSet<T> wanted;
+      wanted.reserve(items->size());
+      for (T item : qAsConst(*items)) wanted.insert(item);
+      QVector<T> sorted;
+      sorted.reserve(items->size());
+      for (const auto &bucket : _buckets) {
+        for (const auto &entry : bucket.second) {
+          if (wanted.contains(entry.second)) sorted.append(entry.second);
+        }
+      }
+      for (T item : qAsConst(*items)) {
+        if (!_places.contains(item)) sorted.append(item);
+      }
+      items->swap(sorted);
+      return;
+    }
+    std::sort(items->begin(), items->end(), [this](T a, T b) {
+      auto placeA = _places.constFind(a), placeB = _places.constFind(b);
+      if (placeB == _places.constEnd()) return placeA != _places.constEnd();
+      if (placeA == _places.constEnd()) return false;
+      if (placeA->depth != placeB->depth) return placeA->depth < placeB->depth;
+      return placeA->sequence < placeB->sequence;
+    });
+  }
+
+ private:
+  struct Place {
+    int depth;
+    quint64 sequence;
+  };
+
+  void Unbucket(const Place &place) {
+    auto bucket = _buckets.find(place.depth);
+    if (bucket == _buckets.end()) return;
+    bucket->second.erase(place.sequence);
+    if (bucket->second.empty()) _buckets.erase(bucket);
+  }
+
+  QHash<T, Place> _places;
+  std::map<int, std::map<quint64, T>> _buckets;
+  quint64 _nextSequence = 0;
+};
+
+#endif  // RENDERLIST_H
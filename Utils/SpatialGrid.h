@@ -0,0 +1,122 @@
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include <QHash>
+#include <QRectF>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+
+// Uniform grid over the bounding rectangles of items (e.g. the instances of a room), for finding the ones in a given
+// area without looking at all of them. Each item is filed under every cell its bounds touch; items spanning too many
+// cells to be worth filing are kept aside and checked on every query instead.
+template <typename T>
+class SpatialGrid {
+ public:
+  explicit SpatialGrid(qreal cellSize = 128) : _cellSize(cellSize) {}
+
+  int Size() const { return _bounds.size(); }
+  bool Contains(T item) const { return _bounds.contains(item); }
+  QRectF Bounds(T item) const { return _bounds.value(item); }
+
+  void Clear() {
+    _cells.clear();
+    _large.clear();
+    _bounds.clear();
+  }
+
+  // Adds the item, or moves it if it is already there.
+  void Insert(T item, const QRectF &bounds) {
+    auto it = _bounds.find(item);
+    if (it != _bounds.end()) {
+      if (*it == bounds) return;
+      Unfile(item, *it);
+      *it = bounds;
+    } else {
+      _bounds.insert(item, bounds);
+    }
+    const CellRange range = Cells(bounds);
+    if (range.Count() > kMaxCellsPerItem) {
+      _large.append({item, bounds});
+      return;
+    }
+    for (int y = range.top; y <= range.bottom; ++y) {
+      for (int x = range.left; x <= range.right; ++x) _cells[Key(x, y)].append({item, bounds});
+    }
+  }
+
+  void Remove(T item) {
+    auto it = _bounds.find(item);
+    if (it == _bounds.end()) return;
+    Unfile(item, *it);
+    _bounds.erase(it);
+  }
+
+  // Items whose bounds intersect the rectangle, each reported once, in no particular order.
+  QVector<T> Query(const QRectF &rect) const {
+    QVector<T> items;
+    for (const Filed &filed : _large) {
+      if (filed.bounds.intersects(rect)) items.append(filed.item);
+    }
+    const CellRange range = Cells(rect);
+    for (int y = range.top; y <= range.bottom; ++y) {
+      for (int x = range.left; x <= range.right; ++x) {
+        auto cell = _cells.constFind(Key(x, y));
+        if (cell == _cells.constEnd()) continue;
+        for (const Filed &filed : *cell) {
+          if (!filed.bounds.intersects(rect)) continue;
+          // Only the first cell the item and the query have in common reports it.
+          const CellRange own = Cells(filed.bounds);
+          if (x == std::max(own.left, range.left) && y == std::max(own.top, range.top)) items.append(filed.item);
+        }
+      }
+    }
+    return items;
+  }
+
+ private:
+  static constexpr int kMaxCellsPerItem = 64;
+
+  struct Filed {
+    T item;
+    QRectF bounds;
+  };
+
+  struct CellRange {
+    int left, top, right, bottom;
+    qint64 Count() const { return qint64(right - left + 1) * (bottom - top + 1); }
+  };
+
+  CellRange Cells(const QRectF &bounds) const {
+    const QRectF r = bounds.normalized();
+    return {int(std::floor(r.left() / _cellSize)), int(std::floor(r.top() / _cellSize)),
+            int(std::floor(r.right() / _cellSize)), int(std::floor(r.bottom() / _cellSize))};
+  }
+
+  static quint64 Key(int x, int y) { return (quint64(quint32(x)) << 32) | quint32(y); }
+
+  void Unfile(T item, const QRectF &bounds) {
+    const auto matches = [item](const Filed &filed) { return filed.item == item; };
+    const CellRange range = Cells(bounds);
+    if (range.Count() > kMaxCellsPerItem) {
+      _large.erase(std::remove_if(_large.begin(), _large.end(), matches), _large.end());
+      return;
+    }
+    for (int y = range.top; y <= range.bottom; ++y) {
+      for (int x = range.left; x <= range.right; ++x) {
+        auto cell = _cells.find(Key(x, y));
+        if (cell == _cells.end()) continue;
+        cell->erase(std::remove_if(cell->begin(), cell->end(), matches), cell->end());
+        if (cell->isEmpty()) _cells.erase(cell);
+      }
+    }
+  }
+
+  qreal _cellSize;
+  QHash<quint64, QVector<Filed>> _cells;
+  QVector<Filed> _large;
+  QHash<T, QRectF> _bounds;
+};
+
+#endif  // SPATIALGRID_H
@@ -7,7 +7,21 @@
 #include <QEvent>
 #include <QKeyEvent>
 #include <QMouseEvent>
+#include <QPaintEvent>
 #include <QPainter>
+#include <QtMath>
+
+namespace {
+
+constexpr int kLayerTileSize = 256;
+// 64MB of tiles at 32 bits per pixel (four times that on a 2x display); past this, tiles out of view are dropped.
+constexpr int kMaxLayerTiles = 256;
+// Past this many separate dirty rects, their bounding rect is redrawn instead.
+constexpr int kMaxDirtyRects = 64;
+
+quint64 LayerTileKey(int x, int y) { return (quint64(quint32(x)) << 32) | quint32(y); }
+
+}  // namespace
 
 AssetScrollAreaBackground::AssetScrollAreaBackground(AssetScrollArea* parent)
     : QWidget(parent),
@@ -17,12 +31,16 @@ AssetScrollAreaBackground::AssetScrollAreaBackground(AssetScrollArea* parent)
       _zoomFactor(2),
       _maxZoom(3200),
       _minZoom(0.0625),
+      _layerZoom(0),
+      _layerPixelRatio(0),
       _backgroundColor(Qt::GlobalColor::gray),
       _viewMoveSpeed(4) {
   installEventFilter(this);
   setMouseTracking(true);
-  // Redraw on an model changes
-  connect(MainWindow::resourceMap, &ResourceModelMap::DataChanged, this, [this]() { this->update(); });
+  // Redraw on model changes, except those the asset view has already invalidated itself
+  connect(MainWindow::resourceMap, &ResourceModelMap::DataChanged, this, [this]() {
+    if (!_assetView || _assetView->ProjectChanged()) InvalidateAsset();
+  });
 }
 
 AssetScrollAreaBackground::~AssetScrollAreaBackground() {
@@ -31,6 +49,7 @@ AssetScrollAreaBackground::~AssetScrollAreaBackground() {
 
 void AssetScrollAreaBackground::SetAssetView(AssetView* asset) {
   _assetView = asset;
+  InvalidateAsset();
   SetZoom(1);
 }
 
@@ -170,7 +189,78 @@ QPoint AssetScrollAreaBackground::MapToAsset(const QPoint &pos) const {
   return (pos - _totalDrawOffset) / _currentZoom;
 }
 
-void AssetScrollAreaBackground::paintEvent(QPaintEvent* /* event */) {
+void AssetScrollAreaBackground::InvalidateAsset(const QRectF& rect) {
+  // Pad for antialiasing and rounding at the edges.
+  const QRect zoomed =
+      QRectF(rect.topLeft() * _currentZoom, rect.size() * _currentZoom).toAlignedRect().adjusted(-2, -2, 2, 2);
+  _dirtyLayers += zoomed;
+  if (_dirtyLayers.rectCount() > kMaxDirtyRects) _dirtyLayers = _dirtyLayers.boundingRect();
+  update(zoomed.translated(_totalDrawOffset));
+}
+
+void AssetScrollAreaBackground::InvalidateAsset() {
+  _layerTiles.clear();
+  _dirtyLayers = QRegion();
+  update();
+}
+
+void AssetScrollAreaBackground::PaintLayers(QPainter& painter, const QRect& exposed) {
+  const qreal pixelRatio = devicePixelRatioF();
+  if (!compareDouble(_layerZoom, _currentZoom) || !compareDouble(_layerPixelRatio, pixelRatio)) {
+    _layerTiles.clear();
+    _dirtyLayers = QRegion();
+    _layerZoom = _currentZoom;
+    _layerPixelRatio = pixelRatio;
+  }
+
+  const QRect area = exposed.translated(-_totalDrawOffset);
+  const int firstX = qFloor(area.left() / qreal(kLayerTileSize)), lastX = qFloor(area.right() / qreal(kLayerTileSize));
+  const int firstY = qFloor(area.top() / qreal(kLayerTileSize)), lastY = qFloor(area.bottom() / qreal(kLayerTileSize));
+
+  QRegion refreshed;
+  for (int y = firstY; y <= lastY; ++y) {
+    for (int x = firstX; x <= lastX; ++x) {
+      const QRect tileRect(x * kLayerTileSize, y * kLayerTileSize, kLayerTileSize, kLayerTileSize);
+      auto it = _layerTiles.find(LayerTileKey(x, y));
+      if (it == _layerTiles.end()) {
+        // Backed at device resolution, so cached layers stay as sharp as painting straight to the widget would be.
+        QPixmap tile(tileRect.size() * pixelRatio);
+        tile.setDevicePixelRatio(pixelRatio);
+        it = _layerTiles.insert(LayerTileKey(x, y), tile);
+        PaintLayerTile(*it, tileRect, tileRect);
+      } else if (_dirtyLayers.intersects(tileRect)) {
+        for (const QRect& dirty : _dirtyLayers.intersected(tileRect)) PaintLayerTile(*it, tileRect, dirty);
+      }
+      refreshed += tileRect;
+      painter.drawPixmap(tileRect.topLeft() + _totalDrawOffset, *it);
+    }
+  }
+  _dirtyLayers -= refreshed;
+
+  if (_layerTiles.size() <= kMaxLayerTiles) return;
+  for (auto it = _layerTiles.begin(); it != _layerTiles.end();) {
+    const int x = qint32(it.key() >> 32), y = qint32(quint32(it.key()));
+    if (x < firstX || x > lastX || y < firstY || y > lastY)
+      it = _layerTiles.erase(it);
+    else
+      ++it;
+  }
+}
+
+void AssetScrollAreaBackground::PaintLayerTile(QPixmap& tile, const QRect& tileRect, const QRect& dirty) {
+  const QRect local = dirty.translated(-tileRect.topLeft());
+  QPainter painter(&tile);
+  painter.setCompositionMode(QPainter::CompositionMode_Source);
+  painter.fillRect(local, Qt::transparent);
+  painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+  painter.setClipRect(local);
+  painter.translate(-tileRect.topLeft());
+  painter.scale(_currentZoom, _currentZoom);
+  _exposedAssetRect = QRectF(QPointF(dirty.topLeft()) / _currentZoom, QSizeF(dirty.size()) / _currentZoom);
+  _assetView->Paint(painter);
+}
+
+void AssetScrollAreaBackground::paintEvent(QPaintEvent* event) {
   QPainter painter(this);
 
   if (_drawSolidBackground) {
@@ -184,12 +274,18 @@ void AssetScrollAreaBackground::paintEvent(QPaintEvent* /* event */) {
 
   if (_assetView != nullptr) {
     _totalDrawOffset = GetCenterOffset() + _userDrawOffset;
-
-    painter.save();
-    painter.translate(_totalDrawOffset);
-    painter.scale(_currentZoom, _currentZoom);
-    _assetView->Paint(painter);
-    painter.restore();
+    if (_assetView->CachesLayers()) {
+      PaintLayers(painter, event->rect());
+    } else {
+      const QRectF exposed(event->rect());
+      _exposedAssetRect = QRectF((exposed.topLeft() - _totalDrawOffset) / _currentZoom, exposed.size() / _currentZoom);
+
+      painter.save();
+      painter.translate(_totalDrawOffset);
+      painter.scale(_currentZoom, _currentZoom);
+      _assetView->Paint(painter);
+      painter.restore();
+    }
 
     GridDimensions g = _assetView->GetGrid();
     if (g.show) {
@@ -3,6 +3,9 @@
 
 #include "AssetScrollArea.h"
 
+#include <QHash>
+#include <QPixmap>
+#include <QRegion>
 #include <QSet>
 #include <QWidget>
 
@@ -34,6 +37,12 @@ class AssetScrollAreaBackground : public QWidget {
   // maps a point on the asset scroll area background (e.g, from mouse event)
   // into the asset with scaling by the zoom and translation
   QPoint MapToAsset(const QPoint &pos) const;
+  // The part of the asset being repainted, in asset coordinates. Only meaningful while the asset view paints.
+  const QRectF& ExposedAssetRect() const { return _exposedAssetRect; }
+  // Marks part of the asset (in asset coordinates) as changed. Views which cache their layers redraw only that part.
+  void InvalidateAsset(const QRectF& rect);
+  // Drops every cached layer, e.g. when something the whole asset depends on has changed.
+  void InvalidateAsset();
 
  public slots:
   void SetZoom(qreal _currentZoom);
@@ -55,6 +64,9 @@ class AssetScrollAreaBackground : public QWidget {
   // Grid used in tilesets
   void PaintGrid(QPainter& painter, int width, int height, int gridHorSpacing, int gridVertSpacing, int gridHorOff,
                  int gridVertOff, int gridWidth, int gridHeight);
+  // Draws the asset view's layers from the tile cache, painting only the tiles or parts of them that are stale.
+  void PaintLayers(QPainter& painter, const QRect& exposed);
+  void PaintLayerTile(QPixmap& tile, const QRect& tileRect, const QRect& dirty);
   void paintEvent(QPaintEvent* event) override;
   bool eventFilter(QObject* obj, QEvent* event) override;
 
@@ -66,6 +78,15 @@ class AssetScrollAreaBackground : public QWidget {
   qreal _minZoom;
   QPoint _totalDrawOffset;
   QPoint _userDrawOffset;
+  QRectF _exposedAssetRect;
+  // The output of AssetView::Paint at the zoom it was drawn at, split into tiles of the zoomed asset.
+  // Tiles are positioned relative to the asset, so panning only moves where they are drawn.
+  QHash<quint64, QPixmap> _layerTiles;
+  qreal _layerZoom;
+  // The device pixel ratio the tiles were allocated for; they are dropped when the widget moves to another screen.
+  qreal _layerPixelRatio;
+  // Parts of the cached tiles, in zoomed asset coordinates, which no longer match the asset.
+  QRegion _dirtyLayers;
   QSet<int> _pressedKeys;
   QColor _backgroundColor;
   int _viewMoveSpeed;
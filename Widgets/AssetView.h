@@ -31,6 +31,12 @@ class AssetView : public QWidget {
   explicit AssetView(AssetScrollAreaBackground* parent);
   virtual void Paint(QPainter& painter) = 0;
   virtual void PaintTop(QPainter& /*painter*/) {}
+  // Whether Paint's output can be kept between frames. Views which do this must report their own changes through
+  // AssetScrollAreaBackground::InvalidateAsset; anything that changes every frame belongs in PaintTop.
+  virtual bool CachesLayers() const { return false; }
+  // Called after each change anywhere in the project. Returns whether the cached layers have to be redrawn, which
+  // views can skip for the changes they already invalidated.
+  virtual bool ProjectChanged() { return true; }
   GridDimensions& GetGrid();
 
  protected:
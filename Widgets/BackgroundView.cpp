@@ -1,14 +1,57 @@
 #include "BackgroundView.h"
 
 #include "Components/ArtManager.h"
+#include "Components/ImageCache.h"
+#include "Utils/ImageKernels.h"
 
 #include "Background.pb.h"
 
+#include <QApplication>
 #include <QMessageBox>
 #include <QPainter>
+#include <QPointer>
+#include <QRunnable>
+#include <QThreadPool>
 
 using buffers::resources::Background;
 
+namespace {
+
+QString KeyedImageName(const QString &file, QRgb key) {
+  return file + QStringLiteral("#key=") + QString::number(key, 16);
+}
+
+}  // namespace
+
+// Keys the transparency color out of a copy of the image, off the GUI thread.
+class BackgroundView::KeyTask : public QRunnable {
+ public:
+  KeyTask(BackgroundView *view, quint64 request, const QString &file, QRgb key, const QImage &image)
+      : _view(view), _request(request), _file(file), _key(key), _image(image) {}
+
+  void run() override {
+    KeyOutColor(&_image, _key);
+    // The view may be gone by the time this runs; only look at it back on the GUI thread.
+    const QPointer<BackgroundView> view = _view;
+    const quint64 request = _request;
+    const QString file = _file;
+    const QRgb key = _key;
+    const QImage image = _image;
+    QMetaObject::invokeMethod(
+        qApp, [view, request, file, key, image]() {
+          if (view) view->TransparencyKeyed(request, file, key, image);
+        },
+        Qt::QueuedConnection);
+  }
+
+ private:
+  QPointer<BackgroundView> _view;
+  quint64 _request;
+  QString _file;
+  QRgb _key;
+  QImage _image;
+};
+
 BackgroundView::BackgroundView(AssetScrollAreaBackground *parent) : AssetView(parent), _model(nullptr) {
   _grid.type = GridType::Complex;
   parent->SetDrawSolidBackground(true, Qt::GlobalColor::transparent);
@@ -19,29 +62,41 @@ void BackgroundView::SetResourceModel(MessageModel *model) {
   SetImage(model->Data(FieldPath::Of<Background>(Background::kImageFieldNumber)).toString());
 }
 
-bool BackgroundView::SetImage(QPixmap image) {
-  if (image.isNull()) return false;
+bool BackgroundView::SetImage(QPixmap image) { return SetPixmap(image, QString()); }
 
-  _pixmap = image;
+bool BackgroundView::SetPixmap(const QPixmap &pixmap, const QString &file) {
+  if (pixmap.isNull()) return false;
 
-  QImage img = _pixmap.toImage();
-  img = img.convertToFormat(QImage::Format_ARGB32);
+  _pixmap = pixmap;
+  _transparentPixmap = QPixmap();
+
+  QImage img = file.isEmpty() ? QImage() : ImageCache::Image(file);
+  if (img.isNull()) img = _pixmap.toImage();
   _transparencyColor = img.pixelColor(0, img.height() - 1);
-  for (int x = 0; x < img.width(); ++x) {
-    for (int y = 0; y < img.height(); ++y) {
-      if (img.pixelColor(x, y) == _transparencyColor) img.setPixelColor(x, y, Qt::transparent);
-    }
+  const QRgb key = _transparencyColor.rgba();
+  const quint64 request = ++_keyRequest;
+  const QImage keyed = file.isEmpty() ? QImage() : ImageCache::Derived(KeyedImageName(file, key));
+  if (!keyed.isNull()) {
+    TransparencyKeyed(request, QString(), key, keyed);
+  } else {
+    QThreadPool::globalInstance()->start(new KeyTask(this, request, file, key, img));
   }
 
-  _transparentPixmap = QPixmap::fromImage(img);
   setFixedSize(_pixmap.width() + 1, _pixmap.height() + 1);
   update();
 
   return true;
 }
 
+void BackgroundView::TransparencyKeyed(quint64 request, const QString &file, QRgb key, const QImage &image) {
+  if (!file.isEmpty()) ImageCache::InsertDerived(KeyedImageName(file, key), image);
+  if (request != _keyRequest) return;
+  _transparentPixmap = QPixmap::fromImage(image);
+  update();
+}
+
 bool BackgroundView::SetImage(QString fName) {
-  if (!SetImage(ArtManager::GetCachedPixmap(fName))) {
+  if (!SetPixmap(ArtManager::GetCachedPixmap(fName), fName)) {
     QMessageBox::critical(this, tr("Failed to load image"), tr("Error opening: ") + fName, QMessageBox::Ok);
     return false;
   }
@@ -67,14 +122,15 @@ void BackgroundView::Paint(QPainter &painter) {
   bool transparent = false;
   painter.drawPixmap(0, 0, (transparent) ? _transparentPixmap : _pixmap);
 
-  if (_model->Data(FieldPath::Of<Background>(Background::kUseAsTilesetFieldNumber)).toBool()) {
+  const Background *background = _model->ReadView<Background>();
+  if (background && background->use_as_tileset()) {
     _grid.show = true;
-    _grid.horSpacing = _model->Data(FieldPath::Of<Background>(Background::kHorizontalSpacingFieldNumber)).toInt();
-    _grid.vertSpacing = _model->Data(FieldPath::Of<Background>(Background::kVerticalSpacingFieldNumber)).toInt();
-    _grid.horOff = _model->Data(FieldPath::Of<Background>(Background::kHorizontalOffsetFieldNumber)).toInt();
-    _grid.vertOff = _model->Data(FieldPath::Of<Background>(Background::kVerticalOffsetFieldNumber)).toInt();
-    _grid.cellWidth = _model->Data(FieldPath::Of<Background>(Background::kTileWidthFieldNumber)).toInt();
-    _grid.cellHeight = _model->Data(FieldPath::Of<Background>(Background::kTileHeightFieldNumber)).toInt();
+    _grid.horSpacing = background->horizontal_spacing();
+    _grid.vertSpacing = background->vertical_spacing();
+    _grid.horOff = background->horizontal_offset();
+    _grid.vertOff = background->vertical_offset();
+    _grid.cellWidth = background->tile_width();
+    _grid.cellHeight = background->tile_height();
     _grid.width = _pixmap.width();
     _grid.height = _pixmap.height();
   } else {
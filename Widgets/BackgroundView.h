@@ -19,10 +19,18 @@ class BackgroundView : public AssetView {
   void Paint(QPainter &painter) override;
 
  private:
+  class KeyTask;
+
+  // The file the pixmap came from, if any, names the cached copy with its transparency color keyed out.
+  bool SetPixmap(const QPixmap &pixmap, const QString &file);
+  void TransparencyKeyed(quint64 request, const QString &file, QRgb key, const QImage &image);
+
   MessageModel *_model;
   QPixmap _pixmap;
   QPixmap _transparentPixmap;
   QColor _transparencyColor;
+  // Only the latest image's keyed copy is kept when several are still being keyed.
+  quint64 _keyRequest = 0;
 };
 
 #endif  // BACKGROUNDVIEW_H
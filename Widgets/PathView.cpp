@@ -56,10 +56,10 @@ int PathView::EffectiveIndex(int n, int size, bool closed) const {
 }
 QPoint PathView::EffectivePoint(int n, int size, bool closed) const { return Point(EffectiveIndex(n, size, closed)); }
 QPoint PathView::Point(int n) const {
-  RepeatedMessageModel *pointsModel = _pathModel->GetSubModel<RepeatedMessageModel *>(Path::kPointsFieldNumber);
-  return QPoint(
-      pointsModel->Data(FieldPath::Of<Path::Point>(FieldPath::StartingAt(n), Path::Point::kXFieldNumber)).toInt(),
-      pointsModel->Data(FieldPath::Of<Path::Point>(FieldPath::StartingAt(n), Path::Point::kYFieldNumber)).toInt());
+  const Path *path = _pathModel->ReadView<Path>();
+  if (!path || n < 0 || n >= path->points_size()) return QPoint();
+  const Path::Point &point = path->points(n);
+  return QPoint(point.x(), point.y());
 }
 
 namespace {
@@ -10,6 +10,8 @@ class PathView : public RoomView {
  public:
   explicit PathView(AssetScrollAreaBackground *parent = nullptr);
   void Paint(QPainter &painter) override;
+  // The path and cursor are redrawn on every move.
+  bool CachesLayers() const override { return false; }
   void SetPathModel(MessageModel *_model);
 
   // Retrieves the number of points in the path.
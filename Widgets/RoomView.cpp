@@ -8,44 +8,344 @@
 
 #include <QDebug>
 #include <QPainter>
+#include <QPointer>
 
-bool InstanceSortFilterProxyModel::lessThan(const QModelIndex& left, const QModelIndex& right) const {
-  QVariant leftData = sourceModel()->data(left);
-  QVariant rightData = sourceModel()->data(right);
+#include <algorithm>
+#include <cmath>
 
-  MessageModel* objA = MainWindow::resourceMap->GetResourceByName(TreeNode::kObject, leftData.toString());
-  MessageModel* objB = MainWindow::resourceMap->GetResourceByName(TreeNode::kObject, rightData.toString());
+namespace {
 
-  if (objA == nullptr || objB == nullptr) return false;
+// Tiles are scaled about the room's origin, position included; see TileItem.
+QRectF TileBounds(const Room::Tile& tile) {
+  return QRectF(tile.x() * tile.xscale(), tile.y() * tile.yscale(), tile.width() * tile.xscale(),
+                tile.height() * tile.yscale())
+      .normalized();
+}
 
-  objA = objA->GetSubModel<MessageModel*>(TreeNode::kObjectFieldNumber);
-  objB = objB->GetSubModel<MessageModel*>(TreeNode::kObjectFieldNumber);
+// Maps an instance's sprite, with its origin at (0, 0), into the room.
+QTransform InstanceTransform(const Room::Instance& instance) {
+  QTransform transform;
+  transform.translate(instance.x(), instance.y());
+  transform.scale(instance.has_xscale() ? instance.xscale() : 1, instance.has_yscale() ? instance.yscale() : 1);
+  transform.rotate(instance.rotation());
+  return transform;
+}
 
-  if (objA == nullptr || objB == nullptr) return false;
+bool SameFragment(const QPainter::PixmapFragment& a, const QPainter::PixmapFragment& b) {
+  return a.x == b.x && a.y == b.y && a.sourceLeft == b.sourceLeft && a.sourceTop == b.sourceTop &&
+         a.width == b.width && a.height == b.height && a.scaleX == b.scaleX && a.scaleY == b.scaleY &&
+         a.rotation == b.rotation && a.opacity == b.opacity;
+}
 
-  return objA->Data(FieldPath::Of<Object>(Object::kDepthFieldNumber)).toInt() <
-         objB->Data(FieldPath::Of<Object>(Object::kDepthFieldNumber)).toInt();
+QPixmap TilePixmap(const QString& backgroundName) {
+  MessageModel* bkg = MainWindow::resourceMap->GetResourceByName(TreeNode::kBackground, backgroundName);
+  if (!bkg) return QPixmap();
+  bkg = bkg->GetSubModel<MessageModel*>(TreeNode::kBackgroundFieldNumber);
+  if (!bkg) return QPixmap();
+  const Background* background = bkg->ReadView<Background>();
+  if (!background) return QPixmap();
+  return ArtManager::GetCachedPixmap(QString::fromStdString(background->image()));
 }
 
+}  // namespace
+
 RoomView::RoomView(AssetScrollAreaBackground* parent) : AssetView(parent), _model(nullptr) {
   setFixedSize(RoomView::sizeHint());
-  _sortedInstances = new InstanceSortFilterProxyModel(this);
-  _sortedTiles = new RepeatedSortFilterProxyModel(this);
+  connect(MainWindow::resourceMap, &ResourceModelMap::DataChanged, this, &RoomView::RefreshObjectLooks);
 }
 
 void RoomView::SetResourceModel(MessageModel* model) {
+  if (_model) _model->disconnect(this);
+  if (_instances) _instances->disconnect(this);
+  if (_tiles) _tiles->disconnect(this);
   _model = model;
+  _instances = nullptr;
+  _tiles = nullptr;
 
   if (model != nullptr) {
-    _sortedInstances->SetSourceModel(model->GetSubModel<RepeatedMessageModel*>(Room::kInstancesFieldNumber));
-    _sortedInstances->sort(Room::Instance::kObjectTypeFieldNumber);
-    _sortedTiles->SetSourceModel(model->GetSubModel<RepeatedMessageModel*>(Room::kTilesFieldNumber));
-    _sortedTiles->sort(Room::Tile::kDepthFieldNumber);
+    _instances = model->GetSubModel<RepeatedMessageModel*>(Room::kInstancesFieldNumber);
+    _tiles = model->GetSubModel<RepeatedMessageModel*>(Room::kTilesFieldNumber);
+
+    // Replacing the room's buffer replaces the models below it too.
+    connect(model, &QAbstractItemModel::modelReset, this, [this]() { SetResourceModel(_model); });
+    connect(model, &ProtoModel::DataChanged, this,
+            [this](const QModelIndex& topLeft, const QModelIndex& bottomRight) {
+              RoomChanged(topLeft.row(), bottomRight.row());
+            });
+    connect(_instances, &QAbstractItemModel::rowsInserted, this,
+            [this](const QModelIndex&, int first, int last) { IndexInstances(first, last); });
+    connect(_instances, &QAbstractItemModel::rowsAboutToBeRemoved, this,
+            [this](const QModelIndex&, int first, int last) { UnindexInstances(first, last); });
+    connect(_instances, &QAbstractItemModel::modelReset, this, &RoomView::RebuildIndex);
+    connect(_instances, &ProtoModel::DataChanged, this,
+            [this](const QModelIndex& topLeft, const QModelIndex& bottomRight) {
+              IndexInstances(topLeft.row(), bottomRight.row());
+            });
+    connect(_tiles, &QAbstractItemModel::rowsInserted, this,
+            [this](const QModelIndex&, int first, int last) { IndexTiles(first, last); });
+    connect(_tiles, &QAbstractItemModel::rowsAboutToBeRemoved, this,
+            [this](const QModelIndex&, int first, int last) { UnindexTiles(first, last); });
+    connect(_tiles, &QAbstractItemModel::modelReset, this, &RoomView::RebuildIndex);
+    connect(_tiles, &ProtoModel::DataChanged, this,
+            [this](const QModelIndex& topLeft, const QModelIndex& bottomRight) {
+              IndexTiles(topLeft.row(), bottomRight.row());
+            });
   }
+  WatchAncestors();
+  RebuildIndex();
   setFixedSize(sizeHint());
   repaint();
 }
 
+void RoomView::WatchAncestors() {
+  for (const QMetaObject::Connection& connection : _ancestorConnections) disconnect(connection);
+  _ancestorConnections.clear();
+  if (!_model) return;
+  // Each model passes a change up as a change to its own row in the parent, and changes are merged per model. So a
+  // change which reaches an ancestor as anything but the row leading down to this room came from somewhere else.
+  auto otherChanged = [this]() { _otherChanged = true; };
+  ProtoModel* child = _model;
+  while (ProtoModel* parent = child->GetParentModel()) {
+    QPointer<ProtoModel> path(child);
+    auto changed = [this, path](const QModelIndex& topLeft, const QModelIndex& bottomRight) {
+      const int row = path ? path->RowInParent() : -1;
+      if (topLeft.row() != row || bottomRight.row() != row) _otherChanged = true;
+    };
+    _ancestorConnections.push_back(connect(parent, &ProtoModel::DataChanged, this, changed));
+    // Resources added, removed or moved around don't come up as data changes at this level.
+    _ancestorConnections.push_back(connect(parent, &QAbstractItemModel::rowsInserted, this, otherChanged));
+    _ancestorConnections.push_back(connect(parent, &QAbstractItemModel::rowsRemoved, this, otherChanged));
+    _ancestorConnections.push_back(connect(parent, &QAbstractItemModel::rowsMoved, this, otherChanged));
+    _ancestorConnections.push_back(connect(parent, &QAbstractItemModel::modelReset, this, otherChanged));
+    child = parent;
+  }
+}
+
+void RoomView::RebuildIndex() {
+  _tileIndex.Clear();
+  _instanceIndex.Clear();
+  _renderItems.clear();
+  _tileOrder.Clear();
+  _instanceOrder.Clear();
+  _objectLooks.clear();
+  _instancesByObject.clear();
+  _instanceObjects.clear();
+  if (_tiles) IndexTiles(0, _tiles->rowCount() - 1);
+  if (_instances) IndexInstances(0, _instances->rowCount() - 1);
+  _parent->InvalidateAsset();
+}
+
+void RoomView::IndexTiles(int first, int last) {
+  for (int row = qMax(first, 0); row <= last && row < _tiles->rowCount(); ++row) {
+    const Room::Tile* tile = _tiles->ReadView<Room::Tile>(row);
+    if (!tile) continue;
+    Refile(_tileIndex, _tileOrder, _tiles->GetSubModel(row), TileBounds(*tile), TileItem(*tile));
+  }
+}
+
+void RoomView::UnindexTiles(int first, int last) {
+  for (int row = first; row <= last; ++row) Unfile(_tileIndex, _tileOrder, _tiles->GetSubModel(row));
+}
+
+void RoomView::IndexInstances(int first, int last) {
+  for (int row = qMax(first, 0); row <= last && row < _instances->rowCount(); ++row) {
+    const Room::Instance* instance = _instances->ReadView<Room::Instance>(row);
+    if (!instance) continue;
+    ProtoModel* model = _instances->GetSubModel(row);
+    const QString object = QString::fromStdString(instance->object_type());
+    auto it = _instanceObjects.find(model);
+    if (it == _instanceObjects.end()) {
+      _instanceObjects.insert(model, object);
+      _instancesByObject[object].insert(model);
+    } else if (*it != object) {
+      _instancesByObject[*it].remove(model);
+      _instancesByObject[object].insert(model);
+      *it = object;
+    }
+    const ObjectLook& look = LookOf(object);
+    Refile(_instanceIndex, _instanceOrder, model, InstanceTransform(*instance).mapRect(look.extent),
+           InstanceItem(*instance, look));
+  }
+}
+
+void RoomView::UnindexInstances(int first, int last) {
+  for (int row = first; row <= last; ++row) {
+    ProtoModel* model = _instances->GetSubModel(row);
+    Unfile(_instanceIndex, _instanceOrder, model);
+    auto it = _instanceObjects.find(model);
+    if (it == _instanceObjects.end()) continue;
+    _instancesByObject[*it].remove(model);
+    _instanceObjects.erase(it);
+  }
+}
+
+const RoomView::ObjectLook& RoomView::LookOf(const QString& object) {
+  auto it = _objectLooks.find(object);
+  if (it == _objectLooks.end()) it = _objectLooks.insert(object, ResolveObject(object));
+  return *it;
+}
+
+RoomView::ObjectLook RoomView::ResolveObject(const QString& object) {
+  ObjectLook look;
+  look.image = "object";
+  look.extent = QRectF(0, 0, 16, 16);
+  MessageModel* obj = MainWindow::resourceMap->GetResourceByName(TreeNode::kObject, object);
+  obj = obj ? obj->GetSubModel<MessageModel*>(TreeNode::kObjectFieldNumber) : nullptr;
+  if (const Object* view = obj ? obj->ReadView<Object>() : nullptr) look.depth = view->depth();
+
+  MessageModel* spr = GetObjectSprite(object);
+  const Sprite* sprite = spr ? spr->ReadView<Sprite>() : nullptr;
+  if (sprite == nullptr || sprite->subimages_size() == 0) return look;
+  look.image = QString::fromStdString(sprite->subimages(0));
+  look.extent = QRectF(-sprite->origin_x(), -sprite->origin_y(), sprite->width(), sprite->height());
+  return look;
+}
+
+RoomView::RenderItem RoomView::TileItem(const Room::Tile& tile) {
+  RenderItem item;
+  item.image = QString::fromStdString(tile.background_name());
+  item.depth = tile.depth();
+  // Tiles are scaled about the room's origin, position included.
+  const QPointF center((tile.x() + tile.width() / 2.0) * tile.xscale(),
+                       (tile.y() + tile.height() / 2.0) * tile.yscale());
+  item.source = QRectF(tile.xoffset(), tile.yoffset(), tile.width(), tile.height());
+  item.fragment = QPainter::PixmapFragment::create(center, item.source, tile.xscale(), tile.yscale());
+  return item;
+}
+
+RoomView::RenderItem RoomView::InstanceItem(const Room::Instance& instance, const ObjectLook& look) {
+  RenderItem item;
+  item.image = look.image;
+  item.depth = look.depth;
+  item.source = QRectF(QPointF(), look.extent.size());
+  const QTransform transform = InstanceTransform(instance);
+  const qreal xscale = instance.has_xscale() ? instance.xscale() : 1;
+  const qreal yscale = instance.has_yscale() ? instance.yscale() : 1;
+  if (xscale != yscale && std::fmod(instance.rotation(), 180) != 0) {
+    item.single = true;
+    item.transform = QTransform::fromTranslate(look.extent.x(), look.extent.y()) * transform;
+    return item;
+  }
+  item.fragment = QPainter::PixmapFragment::create(transform.map(look.extent.center()), item.source, xscale, yscale,
+                                                   instance.rotation());
+  return item;
+}
+
+void RoomView::RefreshObjectLooks() {
+  if (!_instances) return;
+  for (auto it = _instancesByObject.begin(); it != _instancesByObject.end();) {
+    if (it->isEmpty()) {
+      _objectLooks.remove(it.key());
+      it = _instancesByObject.erase(it);
+      continue;
+    }
+    const ObjectLook look = ResolveObject(it.key());
+    if (look != _objectLooks.value(it.key())) {
+      _objectLooks[it.key()] = look;
+      for (ProtoModel* model : qAsConst(*it)) {
+        const int row = model->RowInParent();
+        if (const Room::Instance* instance = _instances->ReadView<Room::Instance>(row)) {
+          Refile(_instanceIndex, _instanceOrder, model, InstanceTransform(*instance).mapRect(look.extent),
+                 InstanceItem(*instance, look));
+        }
+      }
+    }
+    ++it;
+  }
+}
+
+void RoomView::Refile(SpatialGrid<ProtoModel*>& index, RenderList<ProtoModel*>& order, ProtoModel* model,
+                      const QRectF& bounds, const RenderItem& item) {
+  auto it = _renderItems.find(model);
+  if (it != _renderItems.end()) {
+    const QRectF old = index.Bounds(model);
+    if (old == bounds && it->image == item.image && it->depth == item.depth && it->single == item.single &&
+        it->transform == item.transform && it->source == item.source && SameFragment(it->fragment, item.fragment))
+      return;
+    _parent->InvalidateAsset(old);
+    *it = item;
+  } else {
+    _renderItems.insert(model, item);
+  }
+  index.Insert(model, bounds);
+  order.Insert(model, item.depth);
+  _parent->InvalidateAsset(bounds);
+}
+
+void RoomView::Unfile(SpatialGrid<ProtoModel*>& index, RenderList<ProtoModel*>& order, ProtoModel* model) {
+  if (!index.Contains(model)) return;
+  _parent->InvalidateAsset(index.Bounds(model));
+  index.Remove(model);
+  order.Remove(model);
+  _renderItems.remove(model);
+}
+
+void RoomView::RoomChanged(int first, int last) {
+  _roomChanged = true;
+  // Tiles and instances redraw what they cover as they are re-filed; anything else may affect the whole room.
+  static const int instancesRow = Room::descriptor()->FindFieldByNumber(Room::kInstancesFieldNumber)->index();
+  static const int tilesRow = Room::descriptor()->FindFieldByNumber(Room::kTilesFieldNumber)->index();
+  for (int row = first; row <= last; ++row) {
+    if (row == instancesRow || row == tilesRow) continue;
+    _parent->InvalidateAsset();
+    return;
+  }
+}
+
+bool RoomView::ProjectChanged() {
+  // Changes elsewhere (e.g. to a sprite an object here uses) can change any part of the room, even when they came in
+  // together with changes to the room itself.
+  const bool external = _otherChanged || !_roomChanged;
+  _roomChanged = false;
+  _otherChanged = false;
+  return external;
+}
+
+QVector<ProtoModel*> RoomView::ExposedItems(const SpatialGrid<ProtoModel*>& index,
+                                           const RenderList<ProtoModel*>& order) const {
+  QVector<ProtoModel*> exposed = index.Query(_parent->ExposedAssetRect());
+  order.Sort(&exposed);
+  return exposed;
+}
+
+void RoomView::PaintItems(QPainter& painter, const QVector<ProtoModel*>& models, QPixmap (*pixmapFor)(const QString&)) {
+  QVector<const RenderItem*> items;
+  items.reserve(models.size());
+  for (ProtoModel* model : models) {
+    auto it = _renderItems.constFind(model);
+    if (it != _renderItems.constEnd()) items.append(&*it);
+  }
+  for (int first = 0, last = 0; first < items.size(); first = last) {
+    while (last < items.size() && items[last]->depth == items[first]->depth) ++last;
+    std::stable_sort(items.begin() + first, items.begin() + last,
+                     [](const RenderItem* a, const RenderItem* b) { return a->image < b->image; });
+  }
+
+  QVector<QPainter::PixmapFragment> fragments;
+  for (int first = 0, last = 0; first < items.size(); first = last) {
+    const QPixmap pixmap = pixmapFor(items[first]->image);
+    for (; last < items.size() && items[last]->image == items[first]->image; ++last) {
+      const RenderItem& item = *items[last];
+      if (!item.single) {
+        fragments.append(item.fragment);
+        continue;
+      }
+      if (pixmap.isNull()) continue;
+      // Keep the draw order: the fragments before this item go first.
+      painter.drawPixmapFragments(fragments.constData(), fragments.size(), pixmap);
+      fragments.clear();
+      const QTransform transform = painter.transform();
+      painter.setTransform(item.transform, true);
+      painter.drawPixmap(QRectF(QPointF(), item.source.size()), pixmap, item.source);
+      painter.setTransform(transform);
+    }
+    if (!pixmap.isNull() && !fragments.isEmpty()) {
+      painter.drawPixmapFragments(fragments.constData(), fragments.size(), pixmap);
+    }
+    fragments.clear();
+  }
+}
+
 QSize RoomView::sizeHint() const {
   if (!_model) return QSize(640, 480);
   QVariant roomWidth = _model->DataOrDefault(FieldPath::Of<Room>(Room::kWidthFieldNumber), 640),
@@ -57,22 +357,18 @@ void RoomView::Paint(QPainter& painter) {
   _grid.type = GridType::Standard;
 
   if (!_model) return;
+  const Room* room = _model->ReadView<Room>();
+  if (!room) return;
 
-  QVariant hsnap = _model->Data(FieldPath::Of<Room>(Room::kHsnapFieldNumber));
-  QVariant vsnap = _model->Data(FieldPath::Of<Room>(Room::kVsnapFieldNumber));
-  _grid.horSpacing = hsnap.isValid() ? hsnap.toInt() : 16;
-  _grid.vertSpacing = vsnap.isValid() ? vsnap.toInt() : 16;
+  _grid.horSpacing = room->has_hsnap() ? room->hsnap() : 16;
+  _grid.vertSpacing = room->has_vsnap() ? room->vsnap() : 16;
 
   QColor roomColor = QColor(255, 255, 255, 100);
 
-  if (_model->Data(FieldPath::Of<Room>(Room::kShowColorFieldNumber)).toBool())
-    roomColor = _model->Data(FieldPath::Of<Room>(Room::kColorFieldNumber)).toInt();
+  if (room->show_color()) roomColor = QColor(QRgb(room->color()));
 
-  QVariant roomWidth = _model->Data(FieldPath::Of<Room>(Room::kWidthFieldNumber)),
-           roomHeight = _model->Data(FieldPath::Of<Room>(Room::kHeightFieldNumber));
-  painter.fillRect(
-      QRectF(0, 0, roomWidth.isValid() ? roomWidth.toUInt() : 640, roomWidth.isValid() ? roomHeight.toUInt() : 480),
-      QBrush(roomColor));
+  painter.fillRect(QRectF(0, 0, room->has_width() ? room->width() : 640, room->has_width() ? room->height() : 480),
+                   QBrush(roomColor));
 
   paintBackgrounds(painter, false);
   paintTiles(painter);
@@ -81,113 +377,48 @@ void RoomView::Paint(QPainter& painter) {
 }
 
 void RoomView::paintTiles(QPainter& painter) {
-  for (int row = 0; row < _sortedTiles->rowCount(); row++) {
-    QVariant bkgName = _sortedTiles->Data(
-        FieldPath::Of<Room::Tile>(FieldPath::StartingAt(row), Room::Tile::kBackgroundNameFieldNumber));
-    MessageModel* bkg = MainWindow::resourceMap->GetResourceByName(TreeNode::kBackground, bkgName.toString());
-    if (!bkg) continue;
-    bkg = bkg->GetSubModel<MessageModel*>(TreeNode::kBackgroundFieldNumber);
-    if (!bkg) continue;
-
-    int x =
-        _sortedTiles->Data(FieldPath::Of<Room::Tile>(FieldPath::StartingAt(row), Room::Tile::kXFieldNumber)).toInt();
-    int y =
-        _sortedTiles->Data(FieldPath::Of<Room::Tile>(FieldPath::StartingAt(row), Room::Tile::kYFieldNumber)).toInt();
-    int xOff =
-        _sortedTiles->Data(FieldPath::Of<Room::Tile>(FieldPath::StartingAt(row), Room::Tile::kXoffsetFieldNumber))
-            .toInt();
-    int yOff =
-        _sortedTiles->Data(FieldPath::Of<Room::Tile>(FieldPath::StartingAt(row), Room::Tile::kYoffsetFieldNumber))
-            .toInt();
-    int w = _sortedTiles->Data(FieldPath::Of<Room::Tile>(FieldPath::StartingAt(row), Room::Tile::kWidthFieldNumber))
-                .toInt();
-    int h = _sortedTiles->Data(FieldPath::Of<Room::Tile>(FieldPath::StartingAt(row), Room::Tile::kHeightFieldNumber))
-                .toInt();
-
-    QVariant xScale = _sortedTiles->DataOrDefault(
-        FieldPath::Of<Room::Tile>(FieldPath::StartingAt(row), Room::Tile::kXscaleFieldNumber));
-    QVariant yScale = _sortedTiles->DataOrDefault(
-        FieldPath::Of<Room::Tile>(FieldPath::StartingAt(row), Room::Tile::kYscaleFieldNumber));
-
-    QString imgFile = bkg->Data(FieldPath::Of<Background>(Background::kImageFieldNumber)).toString();
-    QPixmap pixmap = ArtManager::GetCachedPixmap(imgFile);
-    if (pixmap.isNull()) continue;
-
-    QRectF dest(x, y, w, h);
-    QRectF src(xOff, yOff, w, h);
-    const QTransform transform = painter.transform();
-    painter.scale(xScale.toFloat(), yScale.toFloat());
-    painter.drawPixmap(dest, pixmap, src);
-    painter.setTransform(transform);
-  }
+  if (!_tiles) return;
+  PaintItems(painter, ExposedItems(_tileIndex, _tileOrder), TilePixmap);
 }
 
 void RoomView::paintBackgrounds(QPainter& painter, bool foregrounds) {
-  RepeatedMessageModel* backgrounds = _model->GetSubModel<RepeatedMessageModel*>(Room::kBackgroundsFieldNumber);
-  for (int row = 0; row < backgrounds->rowCount(); row++) {
-    bool visible =
-        backgrounds
-            ->Data(FieldPath::Of<Room::Background>(FieldPath::StartingAt(row), Room::Background::kVisibleFieldNumber))
-            .toBool();
-    bool foreground = backgrounds
-                          ->Data(FieldPath::Of<Room::Background>(FieldPath::StartingAt(row),
-                                                                 Room::Background::kForegroundFieldNumber))
-                          .toBool();
-    QString bkgName = backgrounds
-                          ->Data(FieldPath::Of<Room::Background>(FieldPath::StartingAt(row),
-                                                                 Room::Background::kBackgroundNameFieldNumber))
-                          .toString();
-
-    if (!visible || foreground != foregrounds) continue;
-    MessageModel* bkgRes = MainWindow::resourceMap->GetResourceByName(TreeNode::kBackground, bkgName);
+  const Room* room = _model->ReadView<Room>();
+  if (!room) return;
+  for (const Room::Background& layer : room->backgrounds()) {
+    if (!layer.visible() || layer.foreground() != foregrounds) continue;
+    MessageModel* bkgRes = MainWindow::resourceMap->GetResourceByName(TreeNode::kBackground, layer.background_name());
     if (!bkgRes) continue;
     bkgRes = bkgRes->GetSubModel<MessageModel*>(TreeNode::kBackgroundFieldNumber);
     if (!bkgRes) continue;
+    const Background* background = bkgRes->ReadView<Background>();
+    if (!background) continue;
+
+    int x = layer.x();
+    int y = layer.y();
+    int w = background->width();
+    int h = background->height();
 
-    int x =
-        backgrounds->Data(FieldPath::Of<Room::Background>(FieldPath::StartingAt(row), Room::Background::kXFieldNumber))
-            .toInt();
-    int y =
-        backgrounds->Data(FieldPath::Of<Room::Background>(FieldPath::StartingAt(row), Room::Background::kYFieldNumber))
-            .toInt();
-    int w = bkgRes->Data(FieldPath::Of<Background>(Background::kWidthFieldNumber)).toInt();
-    int h = bkgRes->Data(FieldPath::Of<Background>(Background::kHeightFieldNumber)).toInt();
-
-    QString imgFile = bkgRes->Data(FieldPath::Of<Background>(Background::kImageFieldNumber)).toString();
-    QPixmap pixmap = ArtManager::GetCachedPixmap(imgFile);
+    QPixmap pixmap = ArtManager::GetCachedPixmap(QString::fromStdString(background->image()));
     if (pixmap.isNull()) continue;
 
     QRectF dest(x, y, w, h);
     QRectF src(0, 0, w, h);
 
-    bool stretch =
-        backgrounds
-            ->Data(FieldPath::Of<Room::Background>(FieldPath::StartingAt(row), Room::Background::kStretchFieldNumber))
-            .toBool();
-    int room_w = _model->Data(FieldPath::Of<Room>(Room::kWidthFieldNumber)).toInt();
-    int room_h = _model->Data(FieldPath::Of<Room>(Room::kHeightFieldNumber)).toInt();
+    int room_w = room->width();
+    int room_h = room->height();
 
     const QTransform transform = painter.transform();
-    if (stretch) {
+    if (layer.stretch()) {
       painter.scale(room_w / qreal(w), room_h / qreal(h));
     }
 
-    bool hTiled =
-        backgrounds
-            ->Data(FieldPath::Of<Room::Background>(FieldPath::StartingAt(row), Room::Background::kHtiledFieldNumber))
-            .toBool();
-    bool vTiled =
-        backgrounds
-            ->Data(FieldPath::Of<Room::Background>(FieldPath::StartingAt(row), Room::Background::kVtiledFieldNumber))
-            .toBool();
-
-    if (hTiled) {
+    if (layer.htiled()) {
       dest.setX(0);
       dest.setWidth(room_w);
       src.setX(x);
     }
 
-    if (vTiled) {
+    if (layer.vtiled()) {
       dest.setY(0);
       dest.setHeight(room_h);
       src.setY(y);
@@ -199,50 +430,6 @@ void RoomView::paintBackgrounds(QPainter& painter, bool foregrounds) {
 }
 
 void RoomView::paintInstances(QPainter& painter) {
-  for (int row = 0; row < _sortedInstances->rowCount(); row++) {
-    QString imgFile = ":/actions/help.png";
-    int w = 16;
-    int h = 16;
-    int xoff = 0;
-    int yoff = 0;
-
-    QVariant sprName = _sortedInstances->Data(
-        FieldPath::Of<Room::Instance>(FieldPath::StartingAt(row), Room::Instance::kObjectTypeFieldNumber));
-
-    MessageModel* spr = GetObjectSprite(sprName.toString());
-    if (spr == nullptr || spr->GetSubModel<RepeatedStringModel*>(Sprite::kSubimagesFieldNumber)->Empty()) {
-      imgFile = "object";
-    } else {
-      imgFile =
-          spr->Data(FieldPath::Of<Sprite>(FieldPath::RepeatedOffset(Sprite::kSubimagesFieldNumber, 0))).toString();
-      w = spr->Data(FieldPath::Of<Sprite>(Sprite::kWidthFieldNumber)).toInt();
-      h = spr->Data(FieldPath::Of<Sprite>(Sprite::kHeightFieldNumber)).toInt();
-      xoff = spr->Data(FieldPath::Of<Sprite>(Sprite::kOriginXFieldNumber)).toInt();
-      yoff = spr->Data(FieldPath::Of<Sprite>(Sprite::kOriginYFieldNumber)).toInt();
-    }
-
-    QPixmap pixmap = ArtManager::GetCachedPixmap(imgFile);
-    if (pixmap.isNull()) continue;
-
-    QVariant x = _sortedInstances->Data(
-        FieldPath::Of<Room::Instance>(FieldPath::StartingAt(row), Room::Instance::kXFieldNumber));
-    QVariant y = _sortedInstances->Data(
-        FieldPath::Of<Room::Instance>(FieldPath::StartingAt(row), Room::Instance::kYFieldNumber));
-    QVariant xScale = _sortedInstances->DataOrDefault(
-        FieldPath::Of<Room::Instance>(FieldPath::StartingAt(row), Room::Instance::kXscaleFieldNumber), 1);
-    QVariant yScale = _sortedInstances->DataOrDefault(
-        FieldPath::Of<Room::Instance>(FieldPath::StartingAt(row), Room::Instance::kYscaleFieldNumber), 1);
-    QVariant rot = _sortedInstances->DataOrDefault(
-        FieldPath::Of<Room::Instance>(FieldPath::StartingAt(row), Room::Instance::kRotationFieldNumber), 0);
-
-    QRectF dest(0, 0, w, h);
-    QRectF src(0, 0, w, h);
-    const QTransform transform = painter.transform();
-    painter.translate(x.toInt(), y.toInt());
-    painter.scale(xScale.toFloat(), yScale.toFloat());
-    painter.rotate(rot.toFloat());
-    painter.translate(-xoff, -yoff);
-    painter.drawPixmap(dest, pixmap, src);
-    painter.setTransform(transform);
-  }
+  if (!_instances) return;
+  PaintItems(painter, ExposedItems(_instanceIndex, _instanceOrder), ArtManager::GetCachedPixmap);
 }
@@ -3,13 +3,15 @@
 
 #include "AssetView.h"
 #include "Models/MessageModel.h"
-#include "Models/RepeatedSortFilterProxyModel.h"
+#include "Models/RepeatedMessageModel.h"
+#include "Utils/RenderList.h"
+#include "Utils/SpatialGrid.h"
 
-class InstanceSortFilterProxyModel : public RepeatedSortFilterProxyModel {
- public:
-  InstanceSortFilterProxyModel(QObject *parent) : RepeatedSortFilterProxyModel(parent) {}
-  bool lessThan(const QModelIndex& left, const QModelIndex& right) const override;
-};
+#include <QHash>
+#include <QPainter>
+#include <QSet>
+
+#include <vector>
 
 class RoomView : public AssetView {
   Q_OBJECT
@@ -19,16 +21,84 @@ class RoomView : public AssetView {
   QSize sizeHint() const override;
   void SetResourceModel(MessageModel *_model);
   void Paint(QPainter &painter) override;
+  bool CachesLayers() const override { return true; }
+  bool ProjectChanged() override;
 
  protected:
+  // How instances of an object are drawn: the first subimage of its sprite, with the sprite's origin at (0, 0).
+  struct ObjectLook {
+    QString image;
+    QRectF extent;
+    int depth = 0;
+    bool operator==(const ObjectLook &other) const {
+      return image == other.image && extent == other.extent && depth == other.depth;
+    }
+    bool operator!=(const ObjectLook &other) const { return !(*this == other); }
+  };
+
+  // How a tile or instance is drawn, built when its row changes so painting only batches these up.
+  struct RenderItem {
+    // The background name of a tile, or the image file of an instance.
+    QString image;
+    int depth = 0;
+    QPainter::PixmapFragment fragment;
+    // Fragments are rotated before they are scaled, so instances both rotated and scaled unevenly are drawn on their
+    // own, with this transform and source.
+    bool single = false;
+    QTransform transform;
+    QRectF source;
+  };
+
   MessageModel *_model;
-  InstanceSortFilterProxyModel *_sortedInstances;
-  RepeatedSortFilterProxyModel *_sortedTiles;
+  RepeatedMessageModel *_instances = nullptr;
+  RepeatedMessageModel *_tiles = nullptr;
   QPixmap _transparentPixmap;
 
+  // Where each tile and instance (by its model) is drawn, so painting only visits what is exposed.
+  SpatialGrid<ProtoModel *> _tileIndex;
+  SpatialGrid<ProtoModel *> _instanceIndex;
+  QHash<ProtoModel *, RenderItem> _renderItems;
+  // Draw order of the tiles and instances, by the depth in their render items.
+  RenderList<ProtoModel *> _tileOrder;
+  RenderList<ProtoModel *> _instanceOrder;
+  // How an instance looks depends on its object, which can change without this room hearing about it.
+  // Keep each object's look and the instances placed with it, to re-file them when it does.
+  QHash<QString, ObjectLook> _objectLooks;
+  QHash<QString, QSet<ProtoModel *>> _instancesByObject;
+  QHash<ProtoModel *, QString> _instanceObjects;
+  // Set when this room changes; those changes invalidate what they touch rather than the whole view.
+  bool _roomChanged = false;
+  // Set when something other than this room changed as well, in the same pass of the event loop.
+  bool _otherChanged = false;
+  std::vector<QMetaObject::Connection> _ancestorConnections;
+
   void paintTiles(QPainter &painter);
   void paintBackgrounds(QPainter &painter, bool foregrounds = false);
   void paintInstances(QPainter &painter);
+
+  void IndexTiles(int first, int last);
+  void IndexInstances(int first, int last);
+  void UnindexTiles(int first, int last);
+  void UnindexInstances(int first, int last);
+  // Moves the item to its new bounds in the index and redraws what it covered before and after, if it changed.
+  void Refile(SpatialGrid<ProtoModel *> &index, RenderList<ProtoModel *> &order, ProtoModel *model,
+              const QRectF &bounds, const RenderItem &item);
+  void Unfile(SpatialGrid<ProtoModel *> &index, RenderList<ProtoModel *> &order, ProtoModel *model);
+  void RoomChanged(int first, int last);
+  // Watches the models above this room for changes that didn't come from it (e.g. to a sprite in the same group).
+  void WatchAncestors();
+  void RebuildIndex();
+  void RefreshObjectLooks();
+  const ObjectLook &LookOf(const QString &object);
+  static ObjectLook ResolveObject(const QString &object);
+  static RenderItem TileItem(const Room::Tile &tile);
+  static RenderItem InstanceItem(const Room::Instance &instance, const ObjectLook &look);
+  // The exposed items in the index, in draw order.
+  QVector<ProtoModel *> ExposedItems(const SpatialGrid<ProtoModel *> &index,
+                                     const RenderList<ProtoModel *> &order) const;
+  // Draws the items in order, except that items of the same depth are grouped by image. Each run of items sharing
+  // an image is drawn in one call, with the pixmap looked up by `pixmapFor`.
+  void PaintItems(QPainter &painter, const QVector<ProtoModel *> &models, QPixmap (*pixmapFor)(const QString &));
 };
 
 #endif  // ROOMVIEW_H
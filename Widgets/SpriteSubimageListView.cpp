@@ -1,3 +1,8 @@
 #include "SpriteSubimageListView.h"
+#include "Components/ThumbnailService.h"
 
-SpriteSubimageListView::SpriteSubimageListView(QWidget* parent) : QListView(parent) {}
+SpriteSubimageListView::SpriteSubimageListView(QWidget* parent) : QListView(parent) {
+  // Icons are looked up on paint, so repainting picks up thumbnails which were still decoding.
+  connect(ThumbnailService::Instance(), &ThumbnailService::ThumbnailsReady, viewport(),
+          static_cast<void (QWidget::*)()>(&QWidget::update));
+}
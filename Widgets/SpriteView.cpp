@@ -1,8 +1,49 @@
 #include "SpriteView.h"
 #include "Components/ArtManager.h"
+#include "Components/ImageCache.h"
 #include "Models/RepeatedPrimitiveModel.h"
+#include "Utils/ImageKernels.h"
+
+#include <QHash>
+#include <QImageReader>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
+
+namespace {
+
+// Opaque bounds of each subimage by its content and the tolerance used, so only new or changed images are scanned.
+QHash<QPair<QByteArray, int>, QRect> opaqueBoundsCache;
+
+// A subimage whose bounds aren't cached. The image is given if the image cache has it; otherwise the task reads it.
+struct OpaqueBoundsJob {
+  QString file;
+  QImage image;
+  QByteArray digest;
+  QRect bounds;
+  bool decoded = false;
+};
+
+class OpaqueBoundsTask : public QRunnable {
+ public:
+  OpaqueBoundsTask(OpaqueBoundsJob *job, int alphaTolerance) : _job(job), _alphaTolerance(alphaTolerance) {}
+
+  void run() override {
+    if (_job->image.isNull()) {
+      _job->image = QImageReader(_job->file).read();
+      if (_job->image.isNull()) return;
+      _job->digest = ImageCache::Digest(_job->image);
+      _job->decoded = true;
+    }
+    _job->bounds = OpaqueBounds(_job->image, _alphaTolerance);
+  }
+
+ private:
+  OpaqueBoundsJob *_job;
+  int _alphaTolerance;
+};
 
-#include <QGraphicsPixmapItem>
+}  // namespace
 
 SpriteView::SpriteView(AssetScrollAreaBackground *parent) : AssetView(parent), _showBBox(true), _showOrigin(true) {
   _grid.show = false;
@@ -48,9 +89,48 @@ void SpriteView::SetShowOrigin(bool show) {
 
 QPixmap &SpriteView::GetPixmap() { return _pixmap; }
 
-QRectF SpriteView::AutomaticBBoxRect() {
-  QGraphicsPixmapItem item(_pixmap);
-  return item.opaqueArea().boundingRect();
+void SpriteView::ClearAutomaticBBoxCache() { opaqueBoundsCache.clear(); }
+
+QRectF SpriteView::AutomaticBBoxRect(int alphaTolerance) {
+  QRect bounds;
+  QVector<OpaqueBoundsJob> jobs;
+  QSet<QString> queued;
+  for (int row = 0; row < _subimgs->rowCount(); ++row) {
+    const QString file = _subimgs->DataAtRow(row).toString();
+    // Files read before are known by content, so their bounds can be looked up without touching the image at all.
+    const QByteArray digest = ImageCache::DigestOf(file);
+    if (!digest.isEmpty()) {
+      auto it = opaqueBoundsCache.constFind({digest, alphaTolerance});
+      if (it != opaqueBoundsCache.constEnd()) {
+        bounds |= *it;
+        continue;
+      }
+    }
+    if (file.isEmpty() || queued.contains(file)) continue;
+    queued.insert(file);
+    OpaqueBoundsJob job;
+    job.file = file;
+    job.image = ImageCache::Cached(file);
+    job.digest = digest;
+    jobs.append(job);
+  }
+
+  // Decode and scan the rest in parallel. The image cache isn't thread safe, so what was decoded is filed into it
+  // here afterwards.
+  if (jobs.size() == 1) {
+    OpaqueBoundsTask(&jobs[0], alphaTolerance).run();
+  } else if (!jobs.isEmpty()) {
+    QThreadPool pool;
+    for (OpaqueBoundsJob &job : jobs) pool.start(new OpaqueBoundsTask(&job, alphaTolerance));
+    pool.waitForDone();
+  }
+  for (const OpaqueBoundsJob &job : qAsConst(jobs)) {
+    if (job.image.isNull()) continue;
+    if (job.decoded) ImageCache::Insert(job.file, job.image, job.digest);
+    opaqueBoundsCache.insert({job.digest, alphaTolerance}, job.bounds);
+    bounds |= job.bounds;
+  }
+  return bounds;
 }
 
 QRectF SpriteView::BBoxRect() {
@@ -16,7 +16,10 @@ class SpriteView : public AssetView {
   void SetResourceModel(MessageModel *model);
   void Paint(QPainter &painter) override;
   void PaintTop(QPainter &painter) override;
-  QRectF AutomaticBBoxRect();
+  // The union of the opaque areas of every subimage, counting pixels with alpha above the tolerance as opaque.
+  QRectF AutomaticBBoxRect(int alphaTolerance = 0);
+  // Forgets the opaque bounds computed so far; call along with clearing the image cache.
+  static void ClearAutomaticBBoxCache();
   QPixmap &GetPixmap();
   QRectF BBoxRect();
 
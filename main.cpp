@@ -1,6 +1,7 @@
 #include "main.h"
 #include "MainWindow.h"
 
+#include "Components/ThumbnailStore.h"
 #include "Dialogs/PreferencesKeys.h"
 
 #include <QApplication>
@@ -33,9 +34,20 @@ int main(int argc, char *argv[]) {
 
   settings.endGroup();  // Preferences
 
+  QString projectFile;
+  for (int i = 1; i < argc; ++i) {
+    const QString arg(argv[i]);
+    if (arg == "--rebuild-thumbnails")
+      ThumbnailStore::Instance()->Clear();
+    else
+      projectFile = arg;
+  }
+  // Created up front, so that it is flushed on exit.
+  ThumbnailStore::Instance();
+
   MainWindow w(nullptr);
-  if (argc > 1) {
-    w.openFile(QString(argv[1]));
+  if (!projectFile.isEmpty()) {
+    w.openFile(projectFile);
   }
   w.show();
 